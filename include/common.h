@@ -5,14 +5,12 @@
 #ifndef PROJECT_BASE_COMMON_H
 #define PROJECT_BASE_COMMON_H
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <learnopengl/mapped_file.h>
 
-std::string readFileContents(std::string path) {
-    std::ifstream in(path);
-    std::stringstream buffer;
-    buffer << in.rdbuf();
-    return buffer.str();
+// goes through MappedFile, so files in the mounted asset pack are found there
+inline std::string readFileContents(std::string path) {
+    MappedFile file(path);
+    return std::string(reinterpret_cast<const char *>(file.data()), file.size());
 }
 
 
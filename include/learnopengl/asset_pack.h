@@ -0,0 +1,323 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// every file under resources/ in one file, opened with a single mmap. MappedFile looks files up
+// here before it touches the disk, so once a pack is mounted the loaders read straight out of
+// its mapping: no open, stat or read per asset, and the pages of neighbouring assets are read
+// ahead together.
+//
+//     | header | entries, sorted by path | path strings | blobs, each aligned to ASSET_PACK_ALIGNMENT |
+//
+// paths are stored relative to the directory holding the pack ("resources/shaders/lit.vs").
+// the pack is a build artifact: --build-pack cooks and caches everything first and packs the
+// result, and loose files are not looked at for anything the pack contains, so it has to be
+// built again (or deleted) after assets change.
+const char ASSET_PACK_MAGIC[4] = {'L', 'P', 'A', 'K'};
+const uint32_t ASSET_PACK_VERSION = 1;
+const uint64_t ASSET_PACK_ALIGNMENT = 64;
+
+struct AssetPackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t padding;
+    uint64_t pathsOffset;
+    uint64_t pathsSize;
+};
+
+struct AssetPackEntry {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t pathOffset;   // into the path strings
+    uint32_t pathLength;
+};
+
+class AssetPack
+{
+public:
+    static AssetPack &instance()
+    {
+        static AssetPack pack;
+        return pack;
+    }
+
+    ~AssetPack()
+    {
+        unmount();
+    }
+
+    AssetPack(const AssetPack &) = delete;
+    AssetPack &operator=(const AssetPack &) = delete;
+
+    // maps a pack and checks that its table fits inside it. mount before the loader threads
+    // start; lookups are read only afterwards and need no lock.
+    // ------------------------------------------------------------------------
+    bool mount(const std::string &path)
+    {
+        unmount();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(AssetPackHeader))
+        {
+            ::close(fd);
+            return false;
+        }
+        void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            return false;
+        bytes = static_cast<const unsigned char *>(mapping);
+        length = info.st_size;
+
+        std::memcpy(&header, bytes, sizeof(header));
+        uint64_t entriesEnd = sizeof(AssetPackHeader) + (uint64_t) header.entryCount * sizeof(AssetPackEntry);
+        if (std::memcmp(header.magic, ASSET_PACK_MAGIC, 4) != 0 || header.version != ASSET_PACK_VERSION ||
+            entriesEnd > length || header.pathsOffset < entriesEnd || header.pathsSize > length - header.pathsOffset)
+            return fail(path);
+        entries = reinterpret_cast<const AssetPackEntry *>(bytes + sizeof(AssetPackHeader));
+        paths = reinterpret_cast<const char *>(bytes + header.pathsOffset);
+        for (uint32_t i = 0; i < header.entryCount; i++)
+        {
+            const AssetPackEntry &entry = entries[i];
+            if ((uint64_t) entry.pathOffset + entry.pathLength > header.pathsSize || entry.offset > length ||
+                entry.size > length - entry.offset)
+                return fail(path);
+        }
+
+        std::string directory = path.find('/') == std::string::npos ? "." : path.substr(0, path.find_last_of('/'));
+        char resolved[PATH_MAX];
+        root = realpath(directory.c_str(), resolved) ? resolved : "";
+        prefix = directory == "." ? "" : directory + '/';
+        return true;
+    }
+
+    // ------------------------------------------------------------------------
+    void unmount()
+    {
+        if (bytes)
+            munmap(const_cast<unsigned char *>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+        entries = nullptr;
+        paths = nullptr;
+        std::memset(&header, 0, sizeof(header));
+    }
+
+    bool mounted() const { return bytes != nullptr; }
+    size_t fileCount() const { return header.entryCount; }
+
+    // the contents of a packed file, found by path: relative to the working directory, or
+    // absolute under the pack's directory as canonicalPath() returns them
+    // ------------------------------------------------------------------------
+    bool find(const std::string &path, const unsigned char *&data, size_t &size) const
+    {
+        if (!mounted())
+            return false;
+        const AssetPackEntry *entry = lookup(key(path));
+        if (!entry)
+            return false;
+        data = bytes + entry->offset;
+        size = entry->size;
+        return true;
+    }
+
+    bool contains(const std::string &path) const
+    {
+        return mounted() && lookup(key(path)) != nullptr;
+    }
+
+    // the path as the pack stores it: made relative to the pack's directory, with ., .. and
+    // repeated separators resolved lexically
+    // ------------------------------------------------------------------------
+    std::string key(const std::string &path) const
+    {
+        std::string relative = path;
+        if (!root.empty() && relative.compare(0, root.size(), root) == 0 && relative.size() > root.size() &&
+            relative[root.size()] == '/')
+            relative = relative.substr(root.size() + 1);
+        else if (!prefix.empty() && relative.compare(0, prefix.size(), prefix) == 0)
+            relative = relative.substr(prefix.size());
+        else if (!relative.empty() && relative[0] == '/')
+            return std::string();
+
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= relative.size())
+        {
+            size_t end = relative.find('/', start);
+            if (end == std::string::npos)
+                end = relative.size();
+            std::string part = relative.substr(start, end - start);
+            if (part == "..")
+            {
+                if (parts.empty())
+                    return std::string();
+                parts.pop_back();
+            }
+            else if (!part.empty() && part != ".")
+                parts.push_back(part);
+            start = end + 1;
+        }
+        std::string normalized;
+        for (const std::string &part : parts)
+            normalized += (normalized.empty() ? "" : "/") + part;
+        return normalized;
+    }
+
+    // packs every regular file below directory (hidden and temporary files excepted) into path,
+    // writing under a temporary name and renaming it into place
+    // ------------------------------------------------------------------------
+    static bool build(const std::string &directory, const std::string &path, size_t &fileCount, uint64_t &dataBytes)
+    {
+        std::vector<std::string> files;
+        listFiles(directory, files);
+        std::sort(files.begin(), files.end());
+
+        std::string pathStrings;
+        std::vector<AssetPackEntry> table(files.size());
+        std::vector<uint64_t> sizes(files.size());
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            struct stat info;
+            if (stat(files[i].c_str(), &info) != 0)
+                return false;
+            sizes[i] = info.st_size;
+            table[i].pathOffset = pathStrings.size();
+            table[i].pathLength = files[i].size();
+            pathStrings += files[i];
+        }
+
+        AssetPackHeader header = {};
+        std::memcpy(header.magic, ASSET_PACK_MAGIC, 4);
+        header.version = ASSET_PACK_VERSION;
+        header.entryCount = files.size();
+        header.pathsOffset = sizeof(AssetPackHeader) + files.size() * sizeof(AssetPackEntry);
+        header.pathsSize = pathStrings.size();
+        uint64_t offset = header.pathsOffset + header.pathsSize;
+        dataBytes = 0;
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            offset = align(offset);
+            table[i].offset = offset;
+            table[i].size = sizes[i];
+            offset += sizes[i];
+            dataBytes += sizes[i];
+        }
+
+        std::string temporary = path + ".tmp";
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(AssetPackEntry));
+        out.write(pathStrings.data(), pathStrings.size());
+        uint64_t written = header.pathsOffset + header.pathsSize;
+        std::vector<char> buffer;
+        const char zeros[ASSET_PACK_ALIGNMENT] = {};
+        for (size_t i = 0; i < files.size() && out; i++)
+        {
+            out.write(zeros, table[i].offset - written);
+            std::ifstream in(files[i], std::ios::binary);
+            buffer.resize(sizes[i]);
+            if (!in.read(buffer.data(), buffer.size()))
+                out.setstate(std::ios::failbit);
+            out.write(buffer.data(), buffer.size());
+            written = table[i].offset + sizes[i];
+        }
+        out.close();
+        if (!out || std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        fileCount = files.size();
+        return true;
+    }
+
+private:
+    const unsigned char *bytes = nullptr;
+    size_t length = 0;
+    AssetPackHeader header = {};
+    const AssetPackEntry *entries = nullptr;
+    const char *paths = nullptr;
+    // the pack's directory, resolved, and as it was given to mount
+    std::string root;
+    std::string prefix;
+
+    AssetPack()
+    {
+    }
+
+    bool fail(const std::string &path)
+    {
+        std::cout << "WARNING::ASSET_PACK:: " << path << " is damaged or from another version, not mounted" << std::endl;
+        unmount();
+        return false;
+    }
+
+    // binary search over the entries, which are sorted by path
+    const AssetPackEntry *lookup(const std::string &key) const
+    {
+        if (key.empty())
+            return nullptr;
+        const AssetPackEntry *first = entries, *last = entries + header.entryCount;
+        const AssetPackEntry *found = std::lower_bound(first, last, key, [this](const AssetPackEntry &entry, const std::string &key) {
+            return key.compare(0, std::string::npos, paths + entry.pathOffset, entry.pathLength) > 0;
+        });
+        if (found == last || key.compare(0, std::string::npos, paths + found->pathOffset, found->pathLength) != 0)
+            return nullptr;
+        return found;
+    }
+
+    static uint64_t align(uint64_t offset)
+    {
+        return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+    }
+
+    static bool packable(const std::string &name)
+    {
+        return name[0] != '.' && (name.size() < 4 || name.compare(name.size() - 4, 4, ".tmp") != 0);
+    }
+
+    static void listFiles(const std::string &directory, std::vector<std::string> &files)
+    {
+        DIR *dir = opendir(directory.c_str());
+        if (!dir)
+            return;
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (!packable(name))
+                continue;
+            std::string path = directory + '/' + name;
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0)
+                continue;
+            if (S_ISDIR(info.st_mode))
+                listFiles(path, files);
+            else if (S_ISREG(info.st_mode))
+                files.push_back(path);
+        }
+        closedir(dir);
+    }
+};
+#endif
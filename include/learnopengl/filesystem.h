@@ -3,6 +3,7 @@
 
 #include <string>
 #include <cstdlib>
+#include <learnopengl/asset_pack.h>
 #include "root_directory.h" // This is a configuration file generated by CMake.
 
 class FileSystem
@@ -11,8 +12,11 @@ private:
   typedef std::string (*Builder) (const std::string& path);
 
 public:
+  // files in the mounted asset pack keep the path the pack knows them by
   static std::string getPath(const std::string& path)
   {
+    if (AssetPack::instance().contains(path))
+      return path;
     static std::string(*pathBuilder)(std::string const &) = getPathBuilder();
     return (*pathBuilder)(path);
   }
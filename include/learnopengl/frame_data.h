@@ -0,0 +1,81 @@
+#ifndef FRAME_DATA_H
+#define FRAME_DATA_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/uniform_buffer.h>
+
+// binding point of the FrameData uniform block, declared by every program
+const unsigned int FRAME_DATA_BINDING = 1;
+
+// mirrors the std140 layout of the FrameData uniform block; viewPos and time share one 16 byte slot
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProj;
+    glm::vec3 viewPos;
+    float time;
+};
+
+static_assert(sizeof(FrameData) == 208, "FrameData doesn't match the std140 layout");
+
+// owns the FrameData uniform buffer and writes it once per frame.
+// the projection matrix is only rebuilt when the camera zoom or the framebuffer size changes.
+class FrameUniforms
+{
+public:
+    FrameData data;
+    float nearPlane;
+    float farPlane;
+
+    FrameUniforms(float nearPlane = 0.1f, float farPlane = 100.0f)
+        : nearPlane(nearPlane), farPlane(farPlane), buffer(sizeof(FrameData), FRAME_DATA_BINDING)
+    {
+    }
+
+    // meant to be called every frame with the current framebuffer size: it only compares the size,
+    // and the projection is rebuilt in update() when it changed. a zero size (minimized window)
+    // keeps the old projection
+    // ------------------------------------------------------------------------
+    void resize(int width, int height)
+    {
+        if (width <= 0 || height <= 0)
+            return;
+        if (width != this->width || height != this->height)
+        {
+            this->width = width;
+            this->height = height;
+            projectionDirty = true;
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    void update(Camera &camera, float time)
+    {
+        if (camera.Zoom != zoom)
+        {
+            zoom = camera.Zoom;
+            projectionDirty = true;
+        }
+        if (projectionDirty && width > 0)
+        {
+            data.projection = glm::perspective(glm::radians(zoom), (float) width / (float) height, nearPlane, farPlane);
+            projectionDirty = false;
+        }
+        data.view = camera.GetViewMatrix();
+        data.viewProj = data.projection * data.view;
+        data.viewPos = camera.Position;
+        data.time = time;
+        buffer.update(data);
+    }
+
+private:
+    UniformBuffer buffer;
+    int width = 0;
+    int height = 0;
+    float zoom = -1.0f;
+    bool projectionDirty = true;
+};
+#endif
@@ -0,0 +1,229 @@
+#ifndef FRUSTUM_CULL_H
+#define FRUSTUM_CULL_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FRUSTUM_CULL_SSE2 1
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FRUSTUM_CULL_AVX 1
+#endif
+
+// CPU culling of instances against the view frustum. every instance is bounded by a sphere, the
+// box of the model's meshes transformed by the instance matrix; the spheres are stored as
+// separate x, y, z and radius arrays so the SSE2 and AVX kernels test 4 or 8 of them against
+// a plane with a few vector instructions. the kernels add in the same order as the scalar
+// reference, so all of them agree exactly on what is visible.
+
+// the six planes of a view-projection matrix, normals pointing inwards and normalized, so
+// dot(plane, (p, 1)) is the signed distance of p
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4 &viewProj)
+    {
+        // rows of the matrix; glm stores columns
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++)
+            rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+        Frustum frustum;
+        for (int i = 0; i < 3; i++)
+        {
+            frustum.planes[2 * i] = rows[3] + rows[i];
+            frustum.planes[2 * i + 1] = rows[3] - rows[i];
+        }
+        for (glm::vec4 &plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+};
+
+// bounding spheres, structure of arrays
+struct CullSpheres {
+    const float *x;
+    const float *y;
+    const float *z;
+    const float *radius;
+};
+
+// writes the indices of the spheres in [begin, end) that touch the frustum to visible, in order,
+// and returns how many there are
+typedef size_t (*CullFunction)(const CullSpheres &spheres, size_t begin, size_t end, const Frustum &frustum,
+                               uint32_t *visible);
+
+struct CullKernel {
+    const char *name;
+    CullFunction cull;
+};
+
+inline size_t cullSpheresScalar(const CullSpheres &spheres, size_t begin, size_t end, const Frustum &frustum,
+                                uint32_t *visible)
+{
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        bool inside = true;
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = plane.x * spheres.x[i] + plane.y * spheres.y[i] + plane.z * spheres.z[i] + plane.w;
+            inside = inside && distance >= -spheres.radius[i];
+        }
+        visible[count] = (uint32_t) i;
+        count += inside;
+    }
+    return count;
+}
+
+#ifdef FRUSTUM_CULL_SSE2
+inline size_t cullSpheresSse2(const CullSpheres &spheres, size_t begin, size_t end, const Frustum &frustum,
+                              uint32_t *visible)
+{
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; p++)
+    {
+        px[p] = _mm_set1_ps(frustum.planes[p].x);
+        py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    size_t count = 0, i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(spheres.x + i), y = _mm_loadu_ps(spheres.y + i), z = _mm_loadu_ps(spheres.z + i);
+        __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(spheres.radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+                                                    _mm_mul_ps(pz[p], z)), pw[p]);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        for (int mask = _mm_movemask_ps(inside); mask; mask &= mask - 1)
+            visible[count++] = (uint32_t) (i + __builtin_ctz(mask));
+    }
+    return count + cullSpheresScalar(spheres, i, end, frustum, visible + count);
+}
+#endif
+
+#ifdef FRUSTUM_CULL_AVX
+__attribute__((target("avx"))) inline size_t cullSpheresAvx(const CullSpheres &spheres, size_t begin, size_t end,
+                                                            const Frustum &frustum, uint32_t *visible)
+{
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; p++)
+    {
+        px[p] = _mm256_set1_ps(frustum.planes[p].x);
+        py[p] = _mm256_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm256_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm256_set1_ps(frustum.planes[p].w);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    size_t count = 0, i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(spheres.x + i), y = _mm256_loadu_ps(spheres.y + i);
+        __m256 z = _mm256_loadu_ps(spheres.z + i);
+        __m256 negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(spheres.radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], x), _mm256_mul_ps(py[p], y)),
+                                                          _mm256_mul_ps(pz[p], z)), pw[p]);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+        }
+        for (int mask = _mm256_movemask_ps(inside); mask; mask &= mask - 1)
+            visible[count++] = (uint32_t) (i + __builtin_ctz(mask));
+    }
+    return count + cullSpheresScalar(spheres, i, end, frustum, visible + count);
+}
+#endif
+
+// every kernel this CPU can run, the scalar reference first and the fastest last
+inline std::vector<CullKernel> cullKernels()
+{
+    std::vector<CullKernel> kernels;
+    kernels.push_back({"scalar", cullSpheresScalar});
+#ifdef FRUSTUM_CULL_SSE2
+    kernels.push_back({"sse2", cullSpheresSse2});
+#endif
+#ifdef FRUSTUM_CULL_AVX
+    if (__builtin_cpu_supports("avx"))
+        kernels.push_back({"avx", cullSpheresAvx});
+#endif
+    return kernels;
+}
+
+inline const CullKernel &cullKernel()
+{
+    static const CullKernel best = cullKernels().back();
+    return best;
+}
+
+// a set of instances sharing one model, culled as a whole every frame. visibleMatrices() holds
+// the transforms of the instances that passed, packed, ready for the instance buffer.
+class InstanceCuller
+{
+public:
+    // the transforms of the instances and the object space box of what they draw
+    // ------------------------------------------------------------------------
+    void setInstances(const glm::mat4 *matrices, size_t count, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+    {
+        this->matrices.assign(matrices, matrices + count);
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        radius.resize(count);
+        indices.resize(count);
+        visible.resize(count);
+        visibleInstances = count;
+
+        glm::vec4 center((boundsMin + boundsMax) * 0.5f, 1.0f);
+        float boxRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::mat4 &matrix = matrices[i];
+            glm::vec3 worldCenter(matrix * center);
+            // the sphere grows with the largest scale of the transform
+            float scale = std::max(glm::length(glm::vec3(matrix[0])),
+                                   std::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+            x[i] = worldCenter.x;
+            y[i] = worldCenter.y;
+            z[i] = worldCenter.z;
+            radius[i] = boxRadius * scale;
+            visible[i] = matrices[i];
+        }
+    }
+
+    // tests every instance against the frustum of viewProj and gathers the visible ones;
+    // returns how many there are
+    // ------------------------------------------------------------------------
+    size_t cull(const glm::mat4 &viewProj, const CullKernel &kernel = cullKernel())
+    {
+        CullSpheres spheres = {x.data(), y.data(), z.data(), radius.data()};
+        visibleInstances = kernel.cull(spheres, 0, matrices.size(), Frustum::fromMatrix(viewProj), indices.data());
+        for (size_t i = 0; i < visibleInstances; i++)
+            visible[i] = matrices[indices[i]];
+        return visibleInstances;
+    }
+
+    const glm::mat4 *visibleMatrices() const { return visible.data(); }
+    size_t visibleCount() const { return visibleInstances; }
+    size_t instanceCount() const { return matrices.size(); }
+
+private:
+    std::vector<glm::mat4> matrices;
+    std::vector<float> x, y, z, radius;
+    std::vector<uint32_t> indices;
+    std::vector<glm::mat4> visible;
+    size_t visibleInstances = 0;
+};
+#endif
@@ -0,0 +1,112 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// glad is generated for the 3.3 core profile, so entry points from later versions and from
+// extensions are loaded here by hand. each feature is only marked available when the context
+// advertises it and every one of its functions resolved.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_QUERY_BUFFER
+#define GL_QUERY_BUFFER 0x9192
+#endif
+
+typedef void (APIENTRYP GLGetProgramBinaryFunction)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                    GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP GLProgramBinaryFunction)(GLuint program, GLenum binaryFormat, const void *binary,
+                                                 GLsizei length);
+typedef void (APIENTRYP GLProgramParameteriFunction)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP GLMaxShaderCompilerThreadsFunction)(GLuint count);
+typedef void (APIENTRYP GLDrawElementsIndirectFunction)(GLenum mode, GLenum type, const void *indirect);
+
+struct GLExtensions {
+    // GL 4.1 or ARB_get_program_binary, with at least one binary format the driver can save
+    bool programBinary = false;
+    GLGetProgramBinaryFunction getProgramBinaryProc = nullptr;
+    GLProgramBinaryFunction programBinaryProc = nullptr;
+    GLProgramParameteriFunction programParameteriProc = nullptr;
+    // KHR_parallel_shader_compile (or the ARB version): compiles and links run on driver threads
+    // and GL_COMPLETION_STATUS_KHR can be polled without waiting for them
+    bool parallelShaderCompile = false;
+    GLMaxShaderCompilerThreadsFunction maxShaderCompilerThreadsProc = nullptr;
+    // GL 4.0 or ARB_draw_indirect: draw parameters read from a buffer
+    bool drawIndirect = false;
+    GLDrawElementsIndirectFunction drawElementsIndirectProc = nullptr;
+    // GL 4.4 or ARB_query_buffer_object: query results written to a buffer by the GPU. no entry
+    // points of its own, glGetQueryObject* write to the bound GL_QUERY_BUFFER
+    bool queryBufferObject = false;
+};
+
+inline GLExtensions &glExtensions()
+{
+    static GLExtensions extensions;
+    return extensions;
+}
+
+inline bool hasGLExtension(const char *extension)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && std::strcmp(name, extension) == 0)
+            return true;
+    }
+    return false;
+}
+
+inline bool hasGLVersion(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+// resolves the optional entry points of the current context; call once on the context thread
+// right after gladLoadGLLoader, with the same loader
+// ------------------------------------------------------------------------
+inline void loadGLExtensions(GLADloadproc load)
+{
+    GLExtensions &extensions = glExtensions();
+    if (hasGLVersion(4, 1) || hasGLExtension("GL_ARB_get_program_binary"))
+    {
+        extensions.getProgramBinaryProc = reinterpret_cast<GLGetProgramBinaryFunction>(load("glGetProgramBinary"));
+        extensions.programBinaryProc = reinterpret_cast<GLProgramBinaryFunction>(load("glProgramBinary"));
+        extensions.programParameteriProc = reinterpret_cast<GLProgramParameteriFunction>(load("glProgramParameteri"));
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        extensions.programBinary = extensions.getProgramBinaryProc && extensions.programBinaryProc &&
+                                   extensions.programParameteriProc && formats > 0;
+    }
+    if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+        extensions.maxShaderCompilerThreadsProc =
+            reinterpret_cast<GLMaxShaderCompilerThreadsFunction>(load("glMaxShaderCompilerThreadsKHR"));
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+        extensions.maxShaderCompilerThreadsProc =
+            reinterpret_cast<GLMaxShaderCompilerThreadsFunction>(load("glMaxShaderCompilerThreadsARB"));
+    extensions.parallelShaderCompile = extensions.maxShaderCompilerThreadsProc != nullptr;
+    // let the driver pick how many threads it compiles on
+    if (extensions.parallelShaderCompile)
+        extensions.maxShaderCompilerThreadsProc(0xFFFFFFFF);
+    if (hasGLVersion(4, 0) || hasGLExtension("GL_ARB_draw_indirect"))
+        extensions.drawElementsIndirectProc =
+            reinterpret_cast<GLDrawElementsIndirectFunction>(load("glDrawElementsIndirect"));
+    extensions.drawIndirect = extensions.drawElementsIndirectProc != nullptr;
+    extensions.queryBufferObject = hasGLVersion(4, 4) || hasGLExtension("GL_ARB_query_buffer_object");
+}
+#endif
@@ -0,0 +1,226 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// kinds of state changes that go through GLState
+enum GLStateCall {
+    GL_STATE_USE_PROGRAM = 0,
+    GL_STATE_BIND_VERTEX_ARRAY,
+    GL_STATE_ACTIVE_TEXTURE,
+    GL_STATE_BIND_TEXTURE,
+    GL_STATE_CAPABILITY,
+    GL_STATE_CULL_FACE,
+    GL_STATE_FRONT_FACE,
+    GL_STATE_CALL_COUNT
+};
+
+// per-frame numbers of calls that reached the driver and calls that were dropped as redundant
+struct GLStateStats {
+    unsigned int issued[GL_STATE_CALL_COUNT] = {};
+    unsigned int skipped[GL_STATE_CALL_COUNT] = {};
+
+    unsigned int totalIssued() const
+    {
+        unsigned int total = 0;
+        for (unsigned int i = 0; i < GL_STATE_CALL_COUNT; i++)
+            total += issued[i];
+        return total;
+    }
+    unsigned int totalSkipped() const
+    {
+        unsigned int total = 0;
+        for (unsigned int i = 0; i < GL_STATE_CALL_COUNT; i++)
+            total += skipped[i];
+        return total;
+    }
+
+    static const char *name(GLStateCall call)
+    {
+        static const char *names[GL_STATE_CALL_COUNT] = {
+            "glUseProgram", "glBindVertexArray", "glActiveTexture", "glBindTexture",
+            "glEnable/glDisable", "glCullFace", "glFrontFace"
+        };
+        return names[call];
+    }
+};
+
+// shadows the bound program, vertex array, 2D textures per unit and a few capability bits,
+// and only forwards calls that actually change something. code that talks to OpenGL directly
+// (ImGui, for example) must call invalidate() afterwards so the shadow copy is not trusted.
+class GLState
+{
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+
+    // ------------------------------------------------------------------------
+    static void useProgram(GLuint program)
+    {
+        State &s = state();
+        if (s.program == program)
+            return skip(GL_STATE_USE_PROGRAM);
+        s.program = program;
+        issue(GL_STATE_USE_PROGRAM);
+        glUseProgram(program);
+    }
+
+    // ------------------------------------------------------------------------
+    static void bindVertexArray(GLuint vao)
+    {
+        State &s = state();
+        if (s.vertexArray == vao)
+            return skip(GL_STATE_BIND_VERTEX_ARRAY);
+        s.vertexArray = vao;
+        issue(GL_STATE_BIND_VERTEX_ARRAY);
+        glBindVertexArray(vao);
+    }
+
+    // ------------------------------------------------------------------------
+    static void activeTexture(unsigned int unit)
+    {
+        State &s = state();
+        if (s.activeUnit == unit)
+            return skip(GL_STATE_ACTIVE_TEXTURE);
+        s.activeUnit = unit;
+        issue(GL_STATE_ACTIVE_TEXTURE);
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // binds a 2D texture to the given unit, switching the active unit only when needed
+    // ------------------------------------------------------------------------
+    static void bindTexture(unsigned int unit, GLuint texture)
+    {
+        State &s = state();
+        if (unit < MAX_TEXTURE_UNITS && s.textures[unit] == texture)
+            return skip(GL_STATE_BIND_TEXTURE);
+        activeTexture(unit);
+        if (unit < MAX_TEXTURE_UNITS)
+            s.textures[unit] = texture;
+        issue(GL_STATE_BIND_TEXTURE);
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+
+    // ------------------------------------------------------------------------
+    static void setEnabled(GLenum capability, bool enabled)
+    {
+        int index = capabilityIndex(capability);
+        State &s = state();
+        if (index >= 0 && s.capabilities[index] == (enabled ? 1 : 0))
+            return skip(GL_STATE_CAPABILITY);
+        if (index >= 0)
+            s.capabilities[index] = enabled ? 1 : 0;
+        issue(GL_STATE_CAPABILITY);
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+    static void enable(GLenum capability) { setEnabled(capability, true); }
+    static void disable(GLenum capability) { setEnabled(capability, false); }
+
+    // ------------------------------------------------------------------------
+    static void cullFace(GLenum mode)
+    {
+        State &s = state();
+        if (s.cullFaceMode == mode)
+            return skip(GL_STATE_CULL_FACE);
+        s.cullFaceMode = mode;
+        issue(GL_STATE_CULL_FACE);
+        glCullFace(mode);
+    }
+
+    // ------------------------------------------------------------------------
+    static void frontFace(GLenum mode)
+    {
+        State &s = state();
+        if (s.frontFaceMode == mode)
+            return skip(GL_STATE_FRONT_FACE);
+        s.frontFaceMode = mode;
+        issue(GL_STATE_FRONT_FACE);
+        glFrontFace(mode);
+    }
+
+    // forgets everything, so the next call of each kind reaches the driver
+    // ------------------------------------------------------------------------
+    static void invalidate()
+    {
+        state() = State();
+    }
+
+    // called before a texture is deleted: GL unbinds it from its units and may hand its name to
+    // the next new texture, whose bind must not be dropped as redundant
+    // ------------------------------------------------------------------------
+    static void forgetTexture(GLuint texture)
+    {
+        State &s = state();
+        for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; i++)
+            if (s.textures[i] == texture)
+                s.textures[i] = UNKNOWN;
+    }
+
+    // starts counting a new frame; the finished frame stays available through lastFrame()
+    // ------------------------------------------------------------------------
+    static void beginFrame()
+    {
+        Counters &c = counters();
+        c.last = c.current;
+        c.current = GLStateStats();
+    }
+
+    static const GLStateStats &currentFrame() { return counters().current; }
+    static const GLStateStats &lastFrame() { return counters().last; }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const unsigned int CAPABILITY_COUNT = 3;
+
+    struct State {
+        GLuint program = UNKNOWN;
+        GLuint vertexArray = UNKNOWN;
+        unsigned int activeUnit = UNKNOWN;
+        GLuint textures[MAX_TEXTURE_UNITS];
+        int capabilities[CAPABILITY_COUNT];  // -1 unknown, 0 disabled, 1 enabled
+        GLenum cullFaceMode = UNKNOWN;
+        GLenum frontFaceMode = UNKNOWN;
+
+        State()
+        {
+            for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; i++)
+                textures[i] = UNKNOWN;
+            for (unsigned int i = 0; i < CAPABILITY_COUNT; i++)
+                capabilities[i] = -1;
+        }
+    };
+
+    struct Counters {
+        GLStateStats current;
+        GLStateStats last;
+    };
+
+    static State &state()
+    {
+        static State instance;
+        return instance;
+    }
+
+    static Counters &counters()
+    {
+        static Counters instance;
+        return instance;
+    }
+
+    static int capabilityIndex(GLenum capability)
+    {
+        switch (capability)
+        {
+            case GL_CULL_FACE: return 0;
+            case GL_DEPTH_TEST: return 1;
+            case GL_BLEND: return 2;
+        }
+        return -1;
+    }
+
+    static void issue(GLStateCall call) { counters().current.issued[call]++; }
+    static void skip(GLStateCall call) { counters().current.skipped[call]++; }
+};
+#endif
@@ -0,0 +1,216 @@
+#ifndef GPU_CULL_H
+#define GPU_CULL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum_cull.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+
+#include <cstddef>
+#include <vector>
+
+// the parameters glDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// frustum culling of instances on the GPU, for counts where culling on the CPU and uploading the
+// survivors every frame (InstanceCuller) costs more than it saves. the matrices are uploaded
+// once. every frame a pass with GL_RASTERIZER_DISCARD draws them as points: cull_instances.vs
+// tests their bounding spheres and cull_instances.gs emits the visible ones, which transform
+// feedback packs into a second buffer that the instanced meshes read from.
+//
+// a GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN query counts what was captured. with indirect draws
+// and query buffer objects the GPU copies that count into the draw commands itself and nothing
+// comes back to the CPU. on plain GL 3.3 the count has to be read back, and reading it right
+// after the pass would stall on it; instead each cull() writes to the next of FRAME_LATENCY
+// buffers with their own queries, and the meshes draw from the newest one whose count is
+// available, usually a frame or two old. buffer and count always belong to the same pass.
+// (glDrawTransformFeedbackInstanced doesn't help here: the captured count would become the
+// vertex count of the draw, where these draws need it as their instance count.)
+class GpuInstanceCuller
+{
+public:
+    static const unsigned int FRAME_LATENCY = 3;
+
+    // the transforms of the instances and the object space box of what they draw
+    // ------------------------------------------------------------------------
+    GpuInstanceCuller(const glm::mat4 *matrices, size_t count, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+        : program("resources/shaders/cull_instances.vs", "resources/shaders/cull_instances.gs",
+                  std::vector<std::string>(1, "instanceMatrix")),
+          instances(count, GL_STATIC_DRAW), instanceTotal(count)
+    {
+        instances.update(matrices, count);
+        glGenVertexArrays(1, &cullVAO);
+        instances.attach(cullVAO, 0);
+
+        program.use();
+        program.setVec3("boundsCenter", (boundsMin + boundsMax) * 0.5f);
+        program.setFloat("boundsRadius", glm::length(boundsMax - boundsMin) * 0.5f);
+        for (int i = 0; i < 6; i++)
+            planes[i] = program.handle("frustumPlanes[" + std::to_string(i) + "]");
+
+        gpuCount = glExtensions().drawIndirect && glExtensions().queryBufferObject;
+        if (gpuCount)
+            glGenBuffers(1, &commandBuffer);
+
+        // the GPU fills in the indirect draws in order, so one buffer is enough there
+        unsigned int slots = gpuCount ? 1 : FRAME_LATENCY;
+        for (unsigned int i = 0; i < slots; i++)
+        {
+            CullSlot slot = {InstanceBuffer(count, GL_DYNAMIC_COPY), 0};
+            glGenQueries(1, &slot.query);
+            visible.push_back(slot);
+        }
+    }
+
+    GpuInstanceCuller(const GpuInstanceCuller &) = delete;
+    GpuInstanceCuller &operator=(const GpuInstanceCuller &) = delete;
+
+    // vertex arrays drawing the visible instances read their matrices from here
+    // ------------------------------------------------------------------------
+    void attach(unsigned int VAO)
+    {
+        attachedVAOs.push_back(VAO);
+        visible[drawSlot].buffer.attach(VAO);
+    }
+
+    // adds an indirect draw command for mesh, whose instance count every cull() fills in, and
+    // returns its offset in commands(); only used when indirect()
+    // ------------------------------------------------------------------------
+    GLintptr addDraw(const Mesh &mesh)
+    {
+        DrawElementsIndirectCommand command = {mesh.indexCount, 0, 0, 0, 0};
+        drawCommands.push_back(command);
+        if (gpuCount)
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, drawCommands.size() * sizeof(DrawElementsIndirectCommand),
+                         drawCommands.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        return (drawCommands.size() - 1) * sizeof(DrawElementsIndirectCommand);
+    }
+
+    // gathers the instances inside the frustum of viewProj into the next visible buffer
+    // ------------------------------------------------------------------------
+    void cull(const glm::mat4 &viewProj)
+    {
+        Frustum frustum = Frustum::fromMatrix(viewProj);
+        program.use();
+        for (int i = 0; i < 6; i++)
+            program.setVec4(planes[i], frustum.planes[i]);
+
+        GLState::bindVertexArray(cullVAO);
+        GLState::enable(GL_RASTERIZER_DISCARD);
+        writeSlot = (writeSlot + 1) % visible.size();
+        CullSlot &slot = visible[writeSlot];
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, slot.buffer.ID);
+        glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, slot.query);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, (GLsizei) instanceTotal);
+        glEndTransformFeedback();
+        glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        GLState::disable(GL_RASTERIZER_DISCARD);
+        GLState::bindVertexArray(0);
+
+        // with a query buffer bound, the result goes to that offset of the buffer, written by the
+        // GPU once the pass is done, instead of to client memory
+        if (gpuCount)
+        {
+            glBindBuffer(GL_QUERY_BUFFER, commandBuffer);
+            for (size_t i = 0; i < drawCommands.size(); i++)
+            {
+                size_t offset = i * sizeof(DrawElementsIndirectCommand) + offsetof(DrawElementsIndirectCommand, instanceCount);
+                glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT, reinterpret_cast<GLuint *>(offset));
+            }
+            glBindBuffer(GL_QUERY_BUFFER, 0);
+            return;
+        }
+        if (drawSlot == writeSlot)
+            drawSlot = NO_SLOT;
+        collectCount();
+    }
+
+    // whether the draws should go through commands() instead of visibleCount()
+    bool indirect() const { return gpuCount; }
+    GLuint commands() const { return commandBuffer; }
+
+    // how many instances the attached vertex arrays should draw when not indirect(): the count
+    // of the pass their matrices currently come from, which may be a frame or two behind
+    GLsizei visibleCount() const { return visibleInstances; }
+
+    size_t instanceCount() const { return instanceTotal; }
+
+private:
+    static const unsigned int NO_SLOT = ~0u;
+
+    // the visible instances of one pass packed at the front of buffer, and the query counting them
+    struct CullSlot {
+        InstanceBuffer buffer;
+        GLuint query;
+    };
+
+    // switches the attached vertex arrays to the newest pass whose count is available. the
+    // passes newer than the one being drawn are checked from newest to oldest; the CPU only
+    // waits when the GPU has fallen FRAME_LATENCY frames behind and the pass being drawn got
+    // overwritten. (until the first result arrives, the empty first buffer is drawn.)
+    // ------------------------------------------------------------------------
+    void collectCount()
+    {
+        unsigned int slots = (unsigned int) visible.size();
+        unsigned int newest = NO_SLOT;
+        for (unsigned int age = 0; age < slots; age++)
+        {
+            unsigned int i = (writeSlot + slots - age) % slots;
+            if (i == drawSlot)
+                break;
+            GLint available = 0;
+            glGetQueryObjectiv(visible[i].query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                newest = i;
+                break;
+            }
+        }
+        if (newest == NO_SLOT)
+        {
+            if (drawSlot != NO_SLOT)
+                return;
+            newest = writeSlot;
+        }
+
+        GLuint count = 0;
+        glGetQueryObjectuiv(visible[newest].query, GL_QUERY_RESULT, &count);
+        visibleInstances = (GLsizei) count;
+        drawSlot = newest;
+        for (unsigned int VAO : attachedVAOs)
+            visible[drawSlot].buffer.attach(VAO);
+    }
+
+    Shader program;
+    UniformHandle planes[6];
+    // every instance, and the visible ones of the last passes
+    InstanceBuffer instances;
+    std::vector<CullSlot> visible;
+    unsigned int writeSlot = 0;
+    unsigned int drawSlot = 0;
+    std::vector<unsigned int> attachedVAOs;
+    size_t instanceTotal;
+    unsigned int cullVAO = 0;
+    bool gpuCount = false;
+    GLuint commandBuffer = 0;
+    std::vector<DrawElementsIndirectCommand> drawCommands;
+    GLsizei visibleInstances = 0;
+};
+#endif
@@ -0,0 +1,20 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a; cheap and good enough to notice that a source file changed.
+// pass the previous result as seed to hash data in several pieces.
+inline uint64_t fnv1a64(const void *data, size_t size, uint64_t seed = 14695981039346656037ull)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+#endif
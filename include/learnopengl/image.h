@@ -0,0 +1,141 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/gl_state.h>
+#include <learnopengl/hash.h>
+#include <learnopengl/ktx.h>
+#include <learnopengl/mapped_file.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// decoded pixels of an image file, or its cooked and compressed mip chain. loading needs no GL
+// context, so it can run on a worker; uploading is done separately on the context thread.
+struct Image {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    unsigned char *pixels = nullptr;
+    // the levels below pixels, built on the loader thread (see mipmap.h); mips[0] is level 1
+    std::vector<std::vector<unsigned char>> mips;
+    // set instead of pixels when the texture comes from the cooker (see texture_cooker.h)
+    KtxTexture cooked;
+    // FNV-1a of the encoded file, identical files decode to identical textures
+    uint64_t contentHash = 0;
+    // bytes loading read from disk, the source and the cooked file
+    size_t bytesRead = 0;
+
+    Image()
+    {
+    }
+
+    ~Image()
+    {
+        if (pixels)
+            stbi_image_free(pixels);
+    }
+
+    Image(const Image &) = delete;
+    Image &operator=(const Image &) = delete;
+
+    bool loaded() const { return pixels || cooked.valid(); }
+
+    // bytes of the uploaded texture including its mip chain
+    size_t textureBytes() const
+    {
+        if (cooked.valid())
+            return cooked.bytes();
+        size_t bytes = (size_t) width * height * components;
+        if (mips.empty())
+            return bytes * 4 / 3;
+        for (const std::vector<unsigned char> &level : mips)
+            bytes += level.size();
+        return bytes;
+    }
+};
+
+// decodes an encoded image held in memory; pixels stay null if it could not be decoded
+// ------------------------------------------------------------------------
+inline void decodeImageFromMemory(const unsigned char *data, size_t size, Image &image)
+{
+    image.contentHash = fnv1a64(data, size);
+    image.pixels = stbi_load_from_memory(data, (int) size, &image.width, &image.height, &image.components, 0);
+}
+
+// decodes an image file; pixels stay null if it could not be read
+// ------------------------------------------------------------------------
+inline void decodeImage(const std::string &path, Image &image)
+{
+    MappedFile file(path);
+    if (!file.valid() || file.size() == 0)
+        return;
+    decodeImageFromMemory(file.data(), file.size(), image);
+}
+
+// creates a mipmapped, repeating 2D texture from a loaded image. cooked images and decoded ones
+// with a CPU built chain upload their precomputed levels, others fall back to glGenerateMipmap.
+// an image that failed to load still gets a texture name, so the caller can bind it like any other.
+// ------------------------------------------------------------------------
+inline unsigned int uploadTexture(const Image &image)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    if (image.cooked.valid())
+    {
+        const KtxTexture &cooked = image.cooked;
+        GLState::bindTexture(0, textureID);
+        for (size_t level = 0; level < cooked.levels.size(); level++)
+        {
+            const KtxTexture::Level &data = cooked.levels[level];
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, cooked.internalFormat, data.width, data.height, 0, data.size, data.data);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked.levels.size() - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return textureID;
+    }
+    if (!image.pixels)
+        return textureID;
+
+    GLenum format = GL_RGBA;
+    if (image.components == 1)
+        format = GL_RED;
+    else if (image.components == 2)
+        format = GL_RG;
+    else if (image.components == 3)
+        format = GL_RGB;
+
+    GLState::bindTexture(0, textureID);
+    // rows of 8 bit levels are tightly packed, which breaks the default 4 byte alignment for
+    // RGB and single channel levels of most widths
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+    if (image.mips.empty())
+        glGenerateMipmap(GL_TEXTURE_2D);
+    else
+    {
+        int width = image.width, height = image.height;
+        for (size_t level = 0; level < image.mips.size(); level++)
+        {
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            glTexImage2D(GL_TEXTURE_2D, level + 1, format, width, height, 0, format, GL_UNSIGNED_BYTE, image.mips[level].data());
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.mips.size());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return textureID;
+}
+#endif
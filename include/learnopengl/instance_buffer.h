@@ -0,0 +1,61 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_state.h>
+
+#include <cstddef>
+
+// per-instance model matrices, rewritten every frame with the instances that survived culling
+// (or, for GpuInstanceCuller, written by the GPU). vertex arrays attached to it read the matrix
+// as the mat4 attribute at locations 5 to 8 (aInstanceMatrix in lit_instanced.vs).
+class InstanceBuffer
+{
+public:
+    unsigned int ID;
+
+    explicit InstanceBuffer(size_t capacity, GLenum usage = GL_STREAM_DRAW) : capacity(capacity), usage(usage)
+    {
+        glGenBuffers(1, &ID);
+        glBindBuffer(GL_ARRAY_BUFFER, ID);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, usage);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // points the instance matrix attribute of a vertex array at this buffer. with a divisor of 0
+    // the matrix advances per vertex instead, for passes that treat each instance as a point.
+    // ------------------------------------------------------------------------
+    void attach(unsigned int VAO, GLuint divisor = 1) const
+    {
+        GLState::bindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, ID);
+        for (unsigned int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(5 + column);
+            glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (void *) (column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(5 + column, divisor);
+        }
+        GLState::bindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // replaces the contents with count matrices (at most the capacity). the old storage is
+    // orphaned first, so the write doesn't wait for draws of the last frame still reading it.
+    // ------------------------------------------------------------------------
+    void update(const glm::mat4 *matrices, size_t count)
+    {
+        count = count < capacity ? count : capacity;
+        glBindBuffer(GL_ARRAY_BUFFER, ID);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, usage);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), matrices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+private:
+    size_t capacity;
+    GLenum usage;
+};
+#endif
@@ -0,0 +1,216 @@
+#ifndef KTX_H
+#define KTX_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/mapped_file.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// KTX 1.1 container (https://registry.khronos.org/KTX/specs/1.0/ktxspec_v1.html) holding a
+// compressed 2D texture with its whole mip chain. only what the cooker writes is supported:
+// little endian, one face, no array layers, compressed formats (glType and glFormat are 0).
+const unsigned char KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+struct KtxHeader {
+    unsigned char identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+// a compressed texture, either mapped from a file or built in memory by the cooker
+class KtxTexture
+{
+public:
+    struct Level {
+        const unsigned char *data;
+        uint32_t size;
+        int width;
+        int height;
+    };
+
+    GLenum internalFormat = 0;
+    GLenum baseFormat = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<Level> levels;
+    // the single key/value pair the cooker writes, describing what the texture was cooked from
+    std::string cookKey;
+
+    bool valid() const { return !levels.empty(); }
+
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (const Level &level : levels)
+            total += level.size;
+        return total;
+    }
+
+    // maps a KTX file and checks that its levels fit inside it
+    // ------------------------------------------------------------------------
+    bool open(const std::string &path)
+    {
+        reset();
+        if (!file.open(path) || file.size() < sizeof(KtxHeader))
+            return false;
+        KtxHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.identifier, KTX_IDENTIFIER, 12) != 0 || header.endianness != KTX_ENDIANNESS ||
+            header.glType != 0 || header.numberOfFaces != 1 || header.numberOfArrayElements != 0 ||
+            header.pixelDepth != 0 || header.numberOfMipmapLevels == 0)
+            return fail();
+
+        size_t offset = sizeof(KtxHeader);
+        if (!inside(offset, header.bytesOfKeyValueData))
+            return fail();
+        size_t end = offset + header.bytesOfKeyValueData;
+        while (offset + 4 <= end)
+        {
+            uint32_t length;
+            std::memcpy(&length, file.data() + offset, 4);
+            offset += 4;
+            if (length > end - offset)
+                return fail();
+            const char *pair = reinterpret_cast<const char *>(file.data() + offset);
+            size_t keyLength = strnlen(pair, length);
+            if (std::string(pair, keyLength) == "cook" && keyLength < length)
+                cookKey.assign(pair + keyLength + 1, strnlen(pair + keyLength + 1, length - keyLength - 1));
+            offset += (length + 3) & ~3u;
+        }
+        offset = end;
+
+        internalFormat = header.glInternalFormat;
+        baseFormat = header.glBaseInternalFormat;
+        width = header.pixelWidth;
+        height = header.pixelHeight;
+        int levelWidth = width, levelHeight = height;
+        for (uint32_t i = 0; i < header.numberOfMipmapLevels; i++)
+        {
+            uint32_t size;
+            if (!inside(offset, 4))
+                return fail();
+            std::memcpy(&size, file.data() + offset, 4);
+            offset += 4;
+            if (!inside(offset, size))
+                return fail();
+            Level level = {file.data() + offset, size, levelWidth, levelHeight};
+            levels.push_back(level);
+            offset += (size + 3) & ~3u;
+            levelWidth = std::max(1, levelWidth / 2);
+            levelHeight = std::max(1, levelHeight / 2);
+        }
+        return true;
+    }
+
+    // takes over levels compressed in memory, largest first
+    // ------------------------------------------------------------------------
+    void assign(GLenum internalFormat, GLenum baseFormat, int width, int height,
+                std::vector<std::vector<unsigned char>> &&data, const std::string &cookKey)
+    {
+        reset();
+        this->internalFormat = internalFormat;
+        this->baseFormat = baseFormat;
+        this->width = width;
+        this->height = height;
+        this->cookKey = cookKey;
+        storage = std::move(data);
+        int levelWidth = width, levelHeight = height;
+        for (const std::vector<unsigned char> &bytes : storage)
+        {
+            Level level = {bytes.data(), (uint32_t) bytes.size(), levelWidth, levelHeight};
+            levels.push_back(level);
+            levelWidth = std::max(1, levelWidth / 2);
+            levelHeight = std::max(1, levelHeight / 2);
+        }
+    }
+
+    // writes the texture under a temporary name and renames it into place
+    // ------------------------------------------------------------------------
+    bool write(const std::string &path) const
+    {
+        std::string temporary = path + ".tmp";
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        std::string pair = std::string("cook") + '\0' + cookKey + '\0';
+        uint32_t pairLength = pair.size();
+        uint32_t pairPadding = (4 - pairLength % 4) % 4;
+
+        KtxHeader header = {};
+        std::memcpy(header.identifier, KTX_IDENTIFIER, 12);
+        header.endianness = KTX_ENDIANNESS;
+        header.glTypeSize = 1;
+        header.glInternalFormat = internalFormat;
+        header.glBaseInternalFormat = baseFormat;
+        header.pixelWidth = width;
+        header.pixelHeight = height;
+        header.numberOfFaces = 1;
+        header.numberOfMipmapLevels = levels.size();
+        header.bytesOfKeyValueData = 4 + pairLength + pairPadding;
+
+        const char zeros[4] = {};
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(&pairLength), 4);
+        out.write(pair.data(), pairLength);
+        out.write(zeros, pairPadding);
+        for (const Level &level : levels)
+        {
+            out.write(reinterpret_cast<const char *>(&level.size), 4);
+            out.write(reinterpret_cast<const char *>(level.data), level.size);
+            out.write(zeros, (4 - level.size % 4) % 4);
+        }
+        out.close();
+        if (!out || std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void reset()
+    {
+        internalFormat = baseFormat = 0;
+        width = height = 0;
+        levels.clear();
+        cookKey.clear();
+        storage.clear();
+        file.close();
+    }
+
+private:
+    MappedFile file;
+    std::vector<std::vector<unsigned char>> storage;
+
+    bool inside(size_t offset, size_t size) const
+    {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+
+    bool fail()
+    {
+        reset();
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,44 @@
+#ifndef LIGHTS_H
+#define LIGHTS_H
+
+#include <glm/glm.hpp>
+
+// binding point of the LightBlock uniform block in the lit shaders
+const unsigned int LIGHT_BLOCK_BINDING = 0;
+const unsigned int NR_SPOT_LIGHTS = 3;
+
+// the structs below mirror the std140 layout of the LightBlock uniform block.
+// every vec3 is followed by a float so each pair fills exactly one 16 byte slot.
+struct PointLight {
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    float padding;
+};
+
+struct SpotLight {
+    glm::vec3 position;
+    float cutOff;
+    glm::vec3 direction;
+    float outerCutOff;
+    glm::vec3 ambient;
+    float constant;
+    glm::vec3 diffuse;
+    float linear;
+    glm::vec3 specular;
+    float quadratic;
+};
+
+struct LightBlock {
+    PointLight pointLight;
+    SpotLight spotlights[NR_SPOT_LIGHTS];
+};
+
+static_assert(sizeof(PointLight) == 64, "PointLight doesn't match the std140 layout");
+static_assert(sizeof(SpotLight) == 80, "SpotLight doesn't match the std140 layout");
+static_assert(sizeof(LightBlock) == 64 + NR_SPOT_LIGHTS * 80, "LightBlock doesn't match the std140 layout");
+#endif
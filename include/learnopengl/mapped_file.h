@@ -0,0 +1,120 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <learnopengl/asset_pack.h>
+
+#include <cstddef>
+#include <string>
+
+// a read-only memory mapping of a whole file. the pages are only read in when touched,
+// so handing data() to glBufferData copies straight from the page cache. files in the mounted
+// AssetPack are not opened at all, the view points into the pack's mapping instead.
+class MappedFile
+{
+public:
+    MappedFile()
+    {
+    }
+
+    explicit MappedFile(const std::string &path)
+    {
+        open(path);
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) : bytes(other.bytes), length(other.length), opened(other.opened), packed(other.packed)
+    {
+        other.bytes = nullptr;
+        other.length = 0;
+        other.opened = false;
+        other.packed = false;
+    }
+
+    MappedFile &operator=(MappedFile &&other)
+    {
+        if (this != &other)
+        {
+            close();
+            bytes = other.bytes;
+            length = other.length;
+            opened = other.opened;
+            packed = other.packed;
+            other.bytes = nullptr;
+            other.length = 0;
+            other.opened = false;
+            other.packed = false;
+        }
+        return *this;
+    }
+
+    // ------------------------------------------------------------------------
+    bool open(const std::string &path)
+    {
+        close();
+        if (AssetPack::instance().find(path, bytes, length))
+        {
+            opened = packed = true;
+            return true;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        length = info.st_size;
+        if (length > 0)
+        {
+            void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            bytes = static_cast<const unsigned char *>(mapping);
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+        opened = true;
+        return true;
+    }
+
+    // ------------------------------------------------------------------------
+    void close()
+    {
+        if (bytes && !packed)
+            munmap(const_cast<unsigned char *>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+        opened = false;
+        packed = false;
+    }
+
+    bool valid() const { return opened; }
+    const unsigned char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char *bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+    // a view into the asset pack, which owns the mapping
+    bool packed = false;
+};
+#endif
@@ -0,0 +1,104 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_state.h>
+
+#include <string>
+
+// every texture of a material has a fixed slot, and the slot is also the texture unit it is bound to.
+// the samplers of a program are pointed at these units once, when the program is linked.
+enum TextureSlot {
+    TEXTURE_DIFFUSE = 0,
+    TEXTURE_SPECULAR,
+    TEXTURE_NORMAL,
+    TEXTURE_HEIGHT,
+    TEXTURE_SLOT_COUNT,
+    TEXTURE_SLOT_NONE = TEXTURE_SLOT_COUNT
+};
+
+// what a texture holds, which decides how it is compressed when it is cooked
+enum TextureUsage {
+    TEXTURE_USAGE_COLOR = 0,
+    TEXTURE_USAGE_NORMAL,
+    TEXTURE_USAGE_HEIGHT
+};
+
+inline TextureUsage textureUsageFromSlot(TextureSlot slot)
+{
+    if (slot == TEXTURE_NORMAL)
+        return TEXTURE_USAGE_NORMAL;
+    if (slot == TEXTURE_HEIGHT)
+        return TEXTURE_USAGE_HEIGHT;
+    return TEXTURE_USAGE_COLOR;
+}
+
+// maps the texture type names used by the model loader to slots; only used at load time
+inline TextureSlot textureSlotFromType(const std::string &type)
+{
+    if (type == "texture_diffuse")
+        return TEXTURE_DIFFUSE;
+    if (type == "texture_specular")
+        return TEXTURE_SPECULAR;
+    if (type == "texture_normal")
+        return TEXTURE_NORMAL;
+    if (type == "texture_height")
+        return TEXTURE_HEIGHT;
+    return TEXTURE_SLOT_NONE;
+}
+
+// maps a sampler uniform to a slot. both the learnopengl names (texture_diffuse1, ...) and the
+// names of our Material structs (material.normalMap, ...) are recognized; anything before
+// the last '.' is ignored. only used when a program is linked.
+inline TextureSlot textureSlotFromSampler(const std::string &uniformName)
+{
+    std::string::size_type dot = uniformName.find_last_of('.');
+    std::string name = dot == std::string::npos ? uniformName : uniformName.substr(dot + 1);
+    if (name == "texture_diffuse1")
+        return TEXTURE_DIFFUSE;
+    if (name == "texture_specular1")
+        return TEXTURE_SPECULAR;
+    if (name == "texture_normal1" || name == "normalMap")
+        return TEXTURE_NORMAL;
+    if (name == "texture_height1" || name == "depthMap")
+        return TEXTURE_HEIGHT;
+    return TEXTURE_SLOT_NONE;
+}
+
+// the textures of a mesh, resolved to slots once at load time, so binding one is a
+// walk over a small array without any string operations.
+class Material
+{
+public:
+    // unique per material, used by the render queue to group draws
+    unsigned int id;
+    unsigned int textures[TEXTURE_SLOT_COUNT] = {};
+
+    Material() : id(nextId())
+    {
+    }
+
+    // ------------------------------------------------------------------------
+    void setTexture(TextureSlot slot, unsigned int texture)
+    {
+        if (slot < TEXTURE_SLOT_COUNT)
+            textures[slot] = texture;
+    }
+
+    // binds every slot to its unit; empty slots are unbound so no texture of the previous material leaks in
+    // ------------------------------------------------------------------------
+    void bind() const
+    {
+        for (unsigned int slot = 0; slot < TEXTURE_SLOT_COUNT; slot++)
+            GLState::bindTexture(slot, textures[slot]);
+    }
+
+private:
+    static unsigned int nextId()
+    {
+        static unsigned int counter = 0;
+        return ++counter;
+    }
+};
+#endif
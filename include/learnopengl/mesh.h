@@ -6,8 +6,14 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/gl_state.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/material.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 using namespace std;
@@ -26,6 +32,94 @@ struct Vertex {
 };
 
 
+// how a mesh keeps its vertices on the GPU. the packed layout cuts vertex fetch to 20 bytes:
+// position as normalized int16 relative to the mesh bounds (the shader applies positionScale
+// and positionOffset), normal and tangent as GL_INT_2_10_10_10_REV with the bitangent sign in
+// the tangent's w, texture coordinates as half floats. the shaders rebuild the bitangent as
+// cross(normal, tangent), flipped where tangent.w is negative; the float layout leaves w at 1.
+enum VertexLayout {
+    VERTEX_LAYOUT_FLOAT = 0,
+    VERTEX_LAYOUT_PACKED
+};
+
+// what a Mesh keeps on the CPU once its buffers are uploaded
+enum MeshResidency {
+    MESH_RESIDENCY_KEEP = 0,    // vertices, indices and textures, as the tutorial Mesh always did
+    MESH_RESIDENCY_RELEASE,     // nothing, the GPU buffers are the only copy
+    MESH_RESIDENCY_POSITIONS    // positions and indices, enough for picking or culling on the CPU
+};
+
+struct PackedVertex {
+    int16_t  Position[4];   // w is padding
+    uint32_t Normal;
+    uint32_t Tangent;
+    uint16_t TexCoords[2];
+};
+
+inline int packSnorm(float value, int bits)
+{
+    int range = (1 << (bits - 1)) - 1;
+    return (int) std::lround(std::min(1.0f, std::max(-1.0f, value)) * range);
+}
+
+inline uint32_t packSnorm10x3(const glm::vec3 &v, float w)
+{
+    return (uint32_t) (packSnorm(v.x, 10) & 0x3FF) | (uint32_t) (packSnorm(v.y, 10) & 0x3FF) << 10 |
+           (uint32_t) (packSnorm(v.z, 10) & 0x3FF) << 20 | (uint32_t) (packSnorm(w, 2) & 0x3) << 30;
+}
+
+// float to IEEE half, rounding to nearest; values out of range become infinity
+inline uint16_t packHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int) ((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if (exponent >= 31)
+        return (uint16_t) (sign | 0x7C00 | ((bits & 0x7FFFFFFF) > 0x7F800000 ? 0x200 : 0));
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return (uint16_t) sign;
+        // subnormal half
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            half++;
+        return (uint16_t) (sign | half);
+    }
+    uint32_t half = sign | (uint32_t) exponent << 10 | mantissa >> 13;
+    // round to nearest, a carry into the exponent is still correct
+    if (mantissa & 0x1000)
+        half++;
+    return (uint16_t) half;
+}
+
+// packs vertices for VERTEX_LAYOUT_PACKED; positions are stored relative to the bounds,
+// as position = positionOffset + positionScale * stored
+inline void packVertices(const Vertex *vertices, unsigned int count, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                         vector<PackedVertex> &packed, glm::vec3 &positionScale, glm::vec3 &positionOffset)
+{
+    positionOffset = (boundsMin + boundsMax) * 0.5f;
+    positionScale = glm::max((boundsMax - boundsMin) * 0.5f, glm::vec3(1e-8f));
+    packed.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const Vertex &vertex = vertices[i];
+        PackedVertex &out = packed[i];
+        glm::vec3 position = (vertex.Position - positionOffset) / positionScale;
+        for (int c = 0; c < 3; c++)
+            out.Position[c] = (int16_t) packSnorm(position[c], 16);
+        out.Position[3] = 0;
+        float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+        out.Normal = packSnorm10x3(vertex.Normal, 0.0f);
+        out.Tangent = packSnorm10x3(vertex.Tangent, handedness);
+        out.TexCoords[0] = packHalf(vertex.TexCoords.x);
+        out.TexCoords[1] = packHalf(vertex.TexCoords.y);
+    }
+}
 
 struct Texture {
     unsigned int id;
@@ -33,90 +127,257 @@ struct Texture {
     string path;
 };
 
+// a texture a mesh refers to before anything is uploaded; path is relative to the model's directory
+struct TextureRef {
+    string type;
+    string path;
+};
+
+// the CPU side of a mesh between parsing and upload. vertexData and indexData point either into
+// the vectors or into memory owned by someone else, a mapped cache file for example.
+struct MeshData {
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;
+    const Vertex        *vertexData = nullptr;
+    unsigned int         vertexCount = 0;
+    const unsigned int  *indexData = nullptr;
+    unsigned int         indexCount = 0;
+    vector<TextureRef>   textures;
+    glm::vec3            boundsMin = glm::vec3(0.0f);
+    glm::vec3            boundsMax = glm::vec3(0.0f);
+    // filled by pack() for VERTEX_LAYOUT_PACKED
+    vector<PackedVertex> packedVertices;
+    glm::vec3            positionScale = glm::vec3(1.0f);
+    glm::vec3            positionOffset = glm::vec3(0.0f);
+
+    // points the data pointers at the owned vectors and computes the bounds from them
+    void useOwnedData()
+    {
+        vertexData = vertices.data();
+        vertexCount = vertices.size();
+        indexData = indices.data();
+        indexCount = indices.size();
+        boundsMin = boundsMax = vertices.empty() ? glm::vec3(0.0f) : vertices[0].Position;
+        for (const Vertex &vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+    }
+
+    // converts the vertices to the packed layout; runs on the loader threads
+    void pack()
+    {
+        packVertices(vertexData, vertexCount, boundsMin, boundsMax, packedVertices, positionScale, positionOffset);
+    }
+};
+
 class Mesh {
 public:
     // mesh Data
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
+    // object space positions, filled instead of vertices by MESH_RESIDENCY_POSITIONS
+    vector<glm::vec3>    positions;
+    MeshResidency residency = MESH_RESIDENCY_KEEP;
+    // the textures resolved to fixed slots, built once here so drawing needs no string compares
+    Material material;
+    // sizes of the uploaded buffers; the vectors above may be empty (see the second constructor)
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    // object space bounding box
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    // how the vertex buffer is laid out, and how the shader turns stored positions back into
+    // object space (identity for VERTEX_LAYOUT_FLOAT)
+    VertexLayout layout = VERTEX_LAYOUT_FLOAT;
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    // type of the uploaded indices: GL_UNSIGNED_SHORT whenever every vertex can be addressed with
+    // 16 bits, GL_UNSIGNED_INT otherwise. draw calls have to pass it along.
+    GLenum indexType = GL_UNSIGNED_INT;
 
     unsigned int VAO;
-    std::string glslIdentifierPrefix;
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures,
+         MeshResidency residency = MESH_RESIDENCY_KEEP)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
 
+        boundsMin = glm::vec3(0.0f);
+        boundsMax = glm::vec3(0.0f);
+        if (!this->vertices.empty())
+        {
+            boundsMin = boundsMax = this->vertices[0].Position;
+            for (const Vertex &vertex : this->vertices)
+            {
+                boundsMin = glm::min(boundsMin, vertex.Position);
+                boundsMax = glm::max(boundsMax, vertex.Position);
+            }
+        }
+
+        setupMaterial();
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->vertices.size(), sizeof(Vertex), this->indices.data(),
+                  this->indices.size());
+        retain(this->vertices.data(), this->indices.data(), residency);
     }
 
-    // render the mesh
-    void Draw(Shader &shader)
+    // uploads vertex and index data that lives elsewhere, a mapped cache file for example;
+    // the CPU copy the residency asks for is taken from it.
+    Mesh(const Vertex *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount,
+         vector<Texture> textures, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+         MeshResidency residency = MESH_RESIDENCY_KEEP)
     {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
-            else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
+        this->textures = std::move(textures);
+        this->boundsMin = boundsMin;
+        this->boundsMax = boundsMax;
+
+        setupMaterial();
+        setupMesh(vertices, vertexCount, sizeof(Vertex), indices, indexCount);
+        retain(vertices, indices, residency);
+    }
+
+    // uploads vertices packed with MeshData::pack(); a kept CPU copy holds the float vertices
+    Mesh(const MeshData &data, vector<Texture> textures, MeshResidency residency = MESH_RESIDENCY_KEEP)
+    {
+        this->textures = std::move(textures);
+        this->boundsMin = data.boundsMin;
+        this->boundsMax = data.boundsMax;
+        layout = VERTEX_LAYOUT_PACKED;
+        positionScale = data.positionScale;
+        positionOffset = data.positionOffset;
+
+        setupMaterial();
+        setupMesh(data.packedVertices.data(), data.packedVertices.size(), sizeof(PackedVertex), data.indexData,
+                  data.indexCount);
+        retain(data.vertexData, data.indexData, residency);
+    }
+
+    // bytes of the vertex and index buffers on the GPU
+    size_t bufferBytes() const
+    {
+        size_t vertexSize = layout == VERTEX_LAYOUT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+        return vertexCount * vertexSize + indexCount * indexSize;
+    }
 
+    // bytes held by the CPU copy
+    size_t residentBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int) +
+               positions.capacity() * sizeof(glm::vec3);
+    }
 
+    // render the mesh. the sampler uniforms of the shader already point at the fixed
+    // texture units of the material slots (see Shader::reflectUniforms).
+    void Draw(Shader &shader)
+    {
+        material.bind();
+        setVertexDecode(shader);
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        // draw mesh. the VAO stays bound, so drawing the same mesh again costs no rebind
+        GLState::bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
 
         // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+        GLState::activeTexture(0);
     }
 
 private:
     // render data
     unsigned int VBO, EBO;
 
+    // the first texture of each type fills its slot
+    void setupMaterial()
+    {
+        for (int i = (int)textures.size() - 1; i >= 0; i--)
+            material.setTexture(textureSlotFromType(textures[i].type), textures[i].id);
+    }
+
+    // keeps what the residency asks for of the data that was just uploaded, which may already be
+    // the member vectors. the material keeps the texture ids, so textures can go with the rest.
+    void retain(const Vertex *vertexData, const unsigned int *indexData, MeshResidency residency)
+    {
+        this->residency = residency;
+        if (residency == MESH_RESIDENCY_KEEP)
+        {
+            if (vertices.data() != vertexData)
+                vertices.assign(vertexData, vertexData + vertexCount);
+            if (indices.data() != indexData)
+                indices.assign(indexData, indexData + indexCount);
+            return;
+        }
+        if (residency == MESH_RESIDENCY_POSITIONS)
+        {
+            positions.resize(vertexCount);
+            for (unsigned int i = 0; i < vertexCount; i++)
+                positions[i] = vertexData[i].Position;
+            if (indices.data() != indexData)
+                indices.assign(indexData, indexData + indexCount);
+        }
+        else
+            vector<unsigned int>().swap(indices);
+        vector<Vertex>().swap(vertices);
+        vector<Texture>().swap(textures);
+    }
+
+    // sets the uniforms the vertex shaders use to decode this mesh's layout
+    void setVertexDecode(Shader &shader) const
+    {
+        const VertexDecodeHandles &decode = shader.vertexDecode();
+        shader.setVec3(decode.positionScale, positionScale);
+        shader.setVec3(decode.positionOffset, positionOffset);
+    }
+
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const void *vertices, unsigned int vertexCount, size_t vertexSize, const unsigned int *indices,
+                   unsigned int indexCount)
     {
+        this->vertexCount = vertexCount;
+        this->indexCount = indexCount;
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * vertexSize, vertices, GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        if (vertexCount <= 65536)
+        {
+            // every index fits in 16 bits, which halves the index buffer and the bandwidth it takes
+            vector<uint16_t> shortIndices(indices, indices + indexCount);
+            indexType = GL_UNSIGNED_SHORT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+        }
+        else
+        {
+            indexType = GL_UNSIGNED_INT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+        }
 
         // set the vertex attribute pointers
+        if (layout == VERTEX_LAYOUT_PACKED)
+            setupPackedAttributes();
+        else
+            setupFloatAttributes();
+
+        GLState::bindVertexArray(0);
+    }
+
+    void setupFloatAttributes()
+    {
         // vertex Positions
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -132,8 +393,22 @@ private:
         // vertex bitangent
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    }
 
-        glBindVertexArray(0);
+    // the normalized formats decode to [-1, 1] in the shader, the half floats to plain floats.
+    // location 4 stays disabled, the shader rebuilds the bitangent from normal and tangent. the
+    // tangent's w is the handedness; GL 3.3 decodes a 2-bit snorm -1 as -1/3, so the shader
+    // looks only at its sign.
+    void setupPackedAttributes()
+    {
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
     }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,251 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/mesh.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// binary cache of an imported model, written next to the source as <model>.cache.
+//
+// layout: MeshCacheHeader, one MeshCacheEntry per mesh, then per mesh its texture references
+// followed by its vertex and index blobs, each blob aligned to 16 bytes. offsets are from the
+// start of the file. a cache is only used when version, import flags, processing settings,
+// vertex size, and the size and hash of the source file all match, otherwise the model is
+// imported again. for an OBJ the source hash covers its material libraries too
+// (objMaterialLibraryHash).
+const char MESH_CACHE_MAGIC[4] = {'L', 'M', 'S', 'H'};
+// version 2: meshes are stored after the optimizations of mesh_optimizer.h
+const uint32_t MESH_CACHE_VERSION = 2;
+
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t importFlags;
+    uint32_t vertexSize;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint32_t meshCount;
+    uint32_t processingHash;  // version and settings of the import time mesh processing
+};
+
+struct MeshCacheEntry {
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t textureOffset;  // textureCount records of | typeLength:32 | pathLength:32 | type | path |
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t textureCount;
+    uint32_t padding;
+    float boundsMin[3];
+    float boundsMax[3];
+};
+
+class MeshCacheReader
+{
+public:
+    // vertexData and indexData of these point into the mapping
+    std::vector<MeshData> meshes;
+
+    // maps the cache and checks it against the source; the views stay valid while the reader lives
+    // ------------------------------------------------------------------------
+    bool open(const std::string &path, uint64_t sourceHash, uint64_t sourceSize, uint32_t importFlags,
+              uint32_t processingHash)
+    {
+        meshes.clear();
+        if (!file.open(path) || file.size() < sizeof(MeshCacheHeader))
+            return false;
+
+        MeshCacheHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MESH_CACHE_MAGIC, 4) != 0 || header.version != MESH_CACHE_VERSION ||
+            header.importFlags != importFlags || header.processingHash != processingHash ||
+            header.vertexSize != sizeof(Vertex) ||
+            header.sourceHash != sourceHash || header.sourceSize != sourceSize)
+            return fail();
+        if (!inside(sizeof(MeshCacheHeader), (uint64_t) header.meshCount * sizeof(MeshCacheEntry)))
+            return fail();
+
+        for (uint32_t i = 0; i < header.meshCount; i++)
+        {
+            MeshCacheEntry entry;
+            std::memcpy(&entry, file.data() + sizeof(MeshCacheHeader) + i * sizeof(MeshCacheEntry), sizeof(entry));
+            if (!inside(entry.vertexOffset, (uint64_t) entry.vertexCount * sizeof(Vertex)) ||
+                !inside(entry.indexOffset, (uint64_t) entry.indexCount * sizeof(unsigned int)))
+                return fail();
+
+            MeshData view;
+            view.vertexData = reinterpret_cast<const Vertex *>(file.data() + entry.vertexOffset);
+            view.vertexCount = entry.vertexCount;
+            view.indexData = reinterpret_cast<const unsigned int *>(file.data() + entry.indexOffset);
+            view.indexCount = entry.indexCount;
+            view.boundsMin = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+            view.boundsMax = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+
+            uint64_t offset = entry.textureOffset;
+            for (uint32_t t = 0; t < entry.textureCount; t++)
+            {
+                uint32_t lengths[2];
+                if (!inside(offset, sizeof(lengths)))
+                    return fail();
+                std::memcpy(lengths, file.data() + offset, sizeof(lengths));
+                offset += sizeof(lengths);
+                if (!inside(offset, (uint64_t) lengths[0] + lengths[1]))
+                    return fail();
+                TextureRef texture;
+                texture.type.assign(reinterpret_cast<const char *>(file.data() + offset), lengths[0]);
+                texture.path.assign(reinterpret_cast<const char *>(file.data() + offset + lengths[0]), lengths[1]);
+                offset += lengths[0] + lengths[1];
+                view.textures.push_back(texture);
+            }
+            meshes.push_back(std::move(view));
+        }
+        return true;
+    }
+
+    // ------------------------------------------------------------------------
+    void close()
+    {
+        meshes.clear();
+        file.close();
+    }
+
+    size_t fileSize() const { return file.size(); }
+
+private:
+    MappedFile file;
+
+    bool inside(uint64_t offset, uint64_t size) const
+    {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+
+    bool fail()
+    {
+        close();
+        return false;
+    }
+};
+
+// writes parsed meshes. the file is written under a temporary name and renamed,
+// so a reader never sees a half written cache.
+// ------------------------------------------------------------------------
+inline bool writeMeshCache(const std::string &path, const std::vector<MeshData> &meshes, uint64_t sourceHash,
+                           uint64_t sourceSize, uint32_t importFlags, uint32_t processingHash)
+{
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+    header.version = MESH_CACHE_VERSION;
+    header.importFlags = importFlags;
+    header.vertexSize = sizeof(Vertex);
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.meshCount = meshes.size();
+    header.processingHash = processingHash;
+
+    // lay the blobs out first, so the entries can be written before them
+    auto align = [](uint64_t offset) { return (offset + 15) & ~(uint64_t) 15; };
+    std::vector<MeshCacheEntry> entries(meshes.size());
+    uint64_t offset = sizeof(MeshCacheHeader) + meshes.size() * sizeof(MeshCacheEntry);
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const MeshData &mesh = meshes[i];
+        MeshCacheEntry &entry = entries[i];
+        entry = MeshCacheEntry();
+        entry.textureOffset = offset;
+        entry.textureCount = mesh.textures.size();
+        for (const TextureRef &texture : mesh.textures)
+            offset += 2 * sizeof(uint32_t) + texture.type.size() + texture.path.size();
+        entry.vertexOffset = offset = align(offset);
+        entry.vertexCount = mesh.vertexCount;
+        offset += (uint64_t) mesh.vertexCount * sizeof(Vertex);
+        entry.indexOffset = offset = align(offset);
+        entry.indexCount = mesh.indexCount;
+        offset += (uint64_t) mesh.indexCount * sizeof(unsigned int);
+        for (int c = 0; c < 3; c++)
+        {
+            entry.boundsMin[c] = mesh.boundsMin[c];
+            entry.boundsMax[c] = mesh.boundsMax[c];
+        }
+    }
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(MeshCacheEntry));
+    uint64_t written = sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry);
+    const char zeros[16] = {};
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        const MeshData &mesh = meshes[i];
+        for (const TextureRef &texture : mesh.textures)
+        {
+            uint32_t lengths[2] = {(uint32_t) texture.type.size(), (uint32_t) texture.path.size()};
+            out.write(reinterpret_cast<const char *>(lengths), sizeof(lengths));
+            out.write(texture.type.data(), texture.type.size());
+            out.write(texture.path.data(), texture.path.size());
+            written += sizeof(lengths) + texture.type.size() + texture.path.size();
+        }
+        out.write(zeros, entries[i].vertexOffset - written);
+        out.write(reinterpret_cast<const char *>(mesh.vertexData), (uint64_t) mesh.vertexCount * sizeof(Vertex));
+        written = entries[i].vertexOffset + (uint64_t) mesh.vertexCount * sizeof(Vertex);
+        out.write(zeros, entries[i].indexOffset - written);
+        out.write(reinterpret_cast<const char *>(mesh.indexData), (uint64_t) mesh.indexCount * sizeof(unsigned int));
+        written = entries[i].indexOffset + (uint64_t) mesh.indexCount * sizeof(unsigned int);
+    }
+    out.close();
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// continues hash over every MTL file the OBJ text references with mtllib, in order, and adds their
+// sizes to bytesRead. the textures of the meshes come from these files, so a cache keyed on the
+// OBJ alone would keep serving the old textures after a material library was edited.
+inline uint64_t objMaterialLibraryHash(const unsigned char *data, size_t size, const std::string &directory,
+                                       uint64_t hash, uint64_t &bytesRead)
+{
+    const char *p = reinterpret_cast<const char *>(data);
+    const char *end = p + size;
+    while (p < end)
+    {
+        const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!lineEnd)
+            lineEnd = end;
+        while (p < lineEnd && (*p == ' ' || *p == '\t'))
+            p++;
+        if (lineEnd - p > 6 && std::memcmp(p, "mtllib", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+        {
+            const char *nameBegin = p + 7, *nameEnd = lineEnd;
+            while (nameBegin < nameEnd && (*nameBegin == ' ' || *nameBegin == '\t'))
+                nameBegin++;
+            while (nameEnd > nameBegin && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+                nameEnd--;
+            std::string name(nameBegin, nameEnd);
+            hash = fnv1a64(name.data(), name.size(), hash);
+            MappedFile library(directory + '/' + name);
+            uint64_t librarySize = library.valid() ? library.size() : 0;
+            hash = fnv1a64(&librarySize, sizeof(librarySize), hash);
+            if (library.valid())
+                hash = fnv1a64(library.data(), library.size(), hash);
+            bytesRead += librarySize;
+        }
+        p = lineEnd + 1;
+    }
+    return hash;
+}
+#endif
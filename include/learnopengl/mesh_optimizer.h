@@ -0,0 +1,402 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// index and vertex processing run once at import, before the mesh cache is written:
+//   0. weldVertices: merges the copies OBJ imports make of every shared face corner
+//   1. optimizeVertexCache: Forsyth's linear speed vertex cache optimization
+//      (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+//   2. optimizeOverdraw: splits that order into clusters at cache restarts and draws the
+//      clusters facing away from the mesh center first, as long as the cache stays efficient
+//   3. optimizeVertexFetch: stores the vertices in the order the indices first use them
+// analyzeVertexCache measures the result on a FIFO cache like the post-transform caches of
+// current GPUs.
+//
+// the mesh cache stores the output of these passes, so any change to what they produce has to
+// bump MESH_OPTIMIZER_VERSION, which is part of the cache key, or old caches keep being served.
+// version 2: vertices are welded first
+const uint32_t MESH_OPTIMIZER_VERSION = 2;
+
+struct VertexCacheStats {
+    float acmr = 0.0f;  // vertices transformed per triangle, 0.5 at best, 3 at worst
+    float atvr = 0.0f;  // vertices transformed per vertex referenced, 1 at best
+};
+
+// ------------------------------------------------------------------------
+inline VertexCacheStats analyzeVertexCache(const unsigned int *indices, size_t indexCount, unsigned int vertexCount,
+                                           unsigned int cacheSize = 16)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3)
+        return stats;
+    // a vertex is in the cache while fewer than cacheSize misses happened since it was loaded
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    unsigned int misses = 0, unique = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unsigned int vertex = indices[i];
+        if (!used[vertex])
+        {
+            used[vertex] = true;
+            unique++;
+        }
+        if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] >= cacheSize)
+        {
+            misses++;
+            loadedAt[vertex] = misses;
+        }
+    }
+    stats.acmr = (float) misses / (indexCount / 3);
+    stats.atvr = (float) misses / unique;
+    return stats;
+}
+
+// ------------------------------------------------------------------------
+// welding
+
+// how far apart two vertices may be and still be merged, per component
+struct WeldTolerance {
+    float position = 1e-5f;
+    float normal = 1e-3f;
+    float texCoord = 1e-5f;
+};
+
+inline bool weldable(const Vertex &a, const Vertex &b, const WeldTolerance &tolerance)
+{
+    glm::vec3 position = glm::abs(a.Position - b.Position);
+    glm::vec3 normal = glm::abs(a.Normal - b.Normal);
+    glm::vec2 texCoords = a.TexCoords - b.TexCoords;
+    if (std::max(std::max(position.x, position.y), position.z) > tolerance.position ||
+        std::max(std::max(normal.x, normal.y), normal.z) > tolerance.normal ||
+        std::max(std::fabs(texCoords.x), std::fabs(texCoords.y)) > tolerance.texCoord)
+        return false;
+    // the tangent frames are averaged, so they have to agree on handedness
+    bool mirroredA = glm::dot(glm::cross(a.Normal, a.Tangent), a.Bitangent) < 0.0f;
+    bool mirroredB = glm::dot(glm::cross(b.Normal, b.Tangent), b.Bitangent) < 0.0f;
+    return mirroredA == mirroredB;
+}
+
+// merges vertices that match within the tolerance and rebuilds the index buffer. vertices are
+// hashed by their position on a grid with the position tolerance as cell size, and compared
+// against the vertices of the neighbouring cells. merged tangents and bitangents are averaged.
+// returns the number of vertices removed.
+// ------------------------------------------------------------------------
+inline size_t weldVertices(MeshData &mesh, const WeldTolerance &tolerance = WeldTolerance())
+{
+    std::vector<Vertex> &vertices = mesh.vertices;
+    size_t original = vertices.size();
+    if (original < 2)
+        return 0;
+
+    // cells are integers computed in double precision: in float, cell + 1 rounds back to cell
+    // once a coordinate passes 2^24 cells (about 168 units at the default tolerance)
+    struct GridCell {
+        int64_t c[3];
+    };
+    double cellSize = std::max(tolerance.position, 1e-12f);
+    auto cellOf = [cellSize](const glm::vec3 &position) {
+        GridCell cell;
+        for (int c = 0; c < 3; c++)
+            cell.c[c] = (int64_t) std::max(std::min(std::floor(position[c] / cellSize), 4e18), -4e18);
+        return cell;
+    };
+    auto cellKey = [](const GridCell &cell, int dx, int dy, int dz) {
+        const int64_t offset[3] = {dx, dy, dz};
+        uint64_t key = 14695981039346656037ull;
+        for (int c = 0; c < 3; c++)
+        {
+            key ^= (uint64_t) (cell.c[c] + offset[c]);
+            key *= 1099511628211ull;
+        }
+        return key;
+    };
+
+    std::unordered_multimap<uint64_t, unsigned int> grid;
+    grid.reserve(original);
+    std::vector<unsigned int> remap(original);
+    std::vector<Vertex> welded;
+    welded.reserve(original);
+    for (size_t i = 0; i < original; i++)
+    {
+        const Vertex &vertex = vertices[i];
+        GridCell cell = cellOf(vertex.Position);
+        unsigned int match = ~0u;
+        for (int dz = -1; dz <= 1 && match == ~0u; dz++)
+            for (int dy = -1; dy <= 1 && match == ~0u; dy++)
+                for (int dx = -1; dx <= 1 && match == ~0u; dx++)
+                {
+                    auto range = grid.equal_range(cellKey(cell, dx, dy, dz));
+                    for (auto it = range.first; it != range.second; ++it)
+                        if (weldable(welded[it->second], vertex, tolerance))
+                        {
+                            match = it->second;
+                            break;
+                        }
+                }
+        if (match == ~0u)
+        {
+            match = welded.size();
+            welded.push_back(vertex);
+            grid.insert(std::make_pair(cellKey(cell, 0, 0, 0), match));
+        }
+        else
+        {
+            welded[match].Tangent += vertex.Tangent;
+            welded[match].Bitangent += vertex.Bitangent;
+        }
+        remap[i] = match;
+    }
+    for (Vertex &vertex : welded)
+    {
+        if (glm::dot(vertex.Tangent, vertex.Tangent) > 0.0f)
+            vertex.Tangent = glm::normalize(vertex.Tangent);
+        if (glm::dot(vertex.Bitangent, vertex.Bitangent) > 0.0f)
+            vertex.Bitangent = glm::normalize(vertex.Bitangent);
+    }
+
+    for (unsigned int &index : mesh.indices)
+        index = remap[index];
+    vertices.swap(welded);
+    mesh.useOwnedData();
+    return original - vertices.size();
+}
+
+// ------------------------------------------------------------------------
+// Forsyth
+
+const int FORSYTH_CACHE_SIZE = 32;
+
+inline float forsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // the vertices of the last triangle get a fixed score, so its neighbours are not
+        // preferred over the rest of the cache just for sharing an edge
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (float) (cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    // vertices with few triangles left are finished first, so they leave the cache for good
+    return score + 2.0f * std::pow((float) remainingTriangles, -0.5f);
+}
+
+// reorders the triangles in place for the post-transform vertex cache
+// ------------------------------------------------------------------------
+inline void optimizeVertexCache(unsigned int *indices, size_t indexCount, unsigned int vertexCount)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2)
+        return;
+
+    // triangles of every vertex; the first remaining[v] entries are the ones not yet emitted
+    std::vector<unsigned int> remaining(vertexCount, 0), offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; i++)
+        remaining[indices[i]]++;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<unsigned int> adjacency(indexCount), fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; i++)
+        adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    long best = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+        if (triangleScore[t] > triangleScore[best])
+            best = t;
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indexCount);
+    std::vector<unsigned int> cache, next;
+    size_t scan = 0;
+    while (result.size() < indexCount)
+    {
+        if (best < 0)
+        {
+            // nothing in the cache has triangles left: continue with the next triangle in order
+            while (emitted[scan])
+                scan++;
+            best = scan;
+        }
+        const unsigned int *triangle = indices + 3 * best;
+        emitted[best] = true;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int vertex = triangle[k];
+            result.push_back(vertex);
+            unsigned int *begin = adjacency.data() + offsets[vertex];
+            unsigned int *end = begin + remaining[vertex];
+            *std::find(begin, end, (unsigned int) best) = *(end - 1);
+            remaining[vertex]--;
+        }
+
+        // the triangle's vertices move to the front of the cache
+        next.assign(triangle, triangle + 3);
+        for (unsigned int vertex : cache)
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                next.push_back(vertex);
+        for (size_t i = 0; i < next.size(); i++)
+        {
+            int position = i < (size_t) FORSYTH_CACHE_SIZE ? (int) i : -1;
+            cachePosition[next[i]] = position;
+            vertexScore[next[i]] = forsythVertexScore(position, remaining[next[i]]);
+        }
+
+        // rescore the triangles of every vertex whose score changed, the best one goes next
+        best = -1;
+        float bestScore = -1.0f;
+        for (unsigned int vertex : next)
+            for (unsigned int i = 0; i < remaining[vertex]; i++)
+            {
+                unsigned int t = adjacency[offsets[vertex] + i];
+                float score = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+                triangleScore[t] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        if (next.size() > (size_t) FORSYTH_CACHE_SIZE)
+            next.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(next);
+    }
+    std::copy(result.begin(), result.end(), indices);
+}
+
+// reorders clusters of the cache optimized triangles so that outward facing ones, which tend
+// to hide the rest, are drawn first. keeps the order if the cache would suffer by more than
+// threshold times the ACMR.
+// ------------------------------------------------------------------------
+inline void optimizeOverdraw(unsigned int *indices, size_t indexCount, const Vertex *vertices, unsigned int vertexCount,
+                             float threshold = 1.05f)
+{
+    const size_t minClusterTriangles = 16;
+    const unsigned int cacheSize = 16;
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2 * minClusterTriangles)
+        return;
+
+    // a cluster starts where the cache restarts, at a triangle whose three vertices all miss
+    std::vector<size_t> clusterStart;
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    unsigned int misses = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        int triangleMisses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int vertex = indices[3 * t + k];
+            if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] >= cacheSize)
+            {
+                misses++;
+                loadedAt[vertex] = misses;
+                triangleMisses++;
+            }
+        }
+        if (clusterStart.empty() || (triangleMisses == 3 && t - clusterStart.back() >= minClusterTriangles))
+            clusterStart.push_back(t);
+    }
+    if (clusterStart.size() < 2)
+        return;
+    clusterStart.push_back(triangleCount);
+
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centers(clusterStart.size() - 1), normals(clusterStart.size() - 1);
+    for (size_t c = 0; c + 1 < clusterStart.size(); c++)
+    {
+        glm::vec3 center(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+        {
+            const glm::vec3 &a = vertices[indices[3 * t]].Position;
+            const glm::vec3 &b = vertices[indices[3 * t + 1]].Position;
+            const glm::vec3 &d = vertices[indices[3 * t + 2]].Position;
+            glm::vec3 cross = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(cross);
+            center += (a + b + d) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCenter += center;
+        meshArea += area;
+        centers[c] = area > 0.0f ? center / area : vertices[indices[3 * clusterStart[c]]].Position;
+        float length = glm::length(normal);
+        normals[c] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+    }
+    if (meshArea > 0.0f)
+        meshCenter = meshCenter / meshArea;
+
+    std::vector<size_t> order(clusterStart.size() - 1);
+    std::vector<float> keys(order.size());
+    for (size_t c = 0; c < order.size(); c++)
+    {
+        order[c] = c;
+        keys[c] = glm::dot(centers[c] - meshCenter, normals[c]);
+    }
+    std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indexCount);
+    for (size_t c : order)
+        sorted.insert(sorted.end(), indices + 3 * clusterStart[c], indices + 3 * clusterStart[c + 1]);
+    float before = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr;
+    float after = analyzeVertexCache(sorted.data(), indexCount, vertexCount, cacheSize).acmr;
+    if (after <= before * threshold)
+        std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+// stores the vertices in first use order and drops the unreferenced ones
+// ------------------------------------------------------------------------
+inline void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+// runs all three passes on an imported mesh and reports its cache efficiency before and after
+// ------------------------------------------------------------------------
+inline void optimizeMesh(MeshData &mesh, VertexCacheStats &before, VertexCacheStats &after)
+{
+    before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    optimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size());
+    optimizeVertexFetch(mesh.vertices, mesh.indices);
+    mesh.useOwnedData();
+    after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+}
+#endif
@@ -0,0 +1,535 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define MIPMAP_SSE2 1
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MIPMAP_AVX2 1
+#endif
+
+// CPU mip chain generation, run on the loader threads so the context thread only uploads.
+//
+// every level is filtered from the one above it, kept in float, with a separable 2:1 filter:
+// rows first, then columns. sRGB color channels are decoded to linear light before filtering
+// and encoded again when a level is stored; alpha is always linear. source pixels past the
+// edge repeat the edge. the inner loops work on contiguous spans of floats whatever the pixel
+// format, so the SSE2 and AVX2 kernels only have to provide a few span operations;
+// generateMipChainReference() is the plain scalar version they are checked against.
+
+enum MipFilter {
+    MIP_FILTER_BOX = 0,  // 2x2 average
+    MIP_FILTER_KAISER    // 8 tap windowed sinc, sharper, with a little ringing
+};
+
+struct MipOptions {
+    MipFilter filter = MIP_FILTER_KAISER;
+    bool srgb = false;
+};
+
+// number of levels in a full mip chain down to 1x1
+inline int mipLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+// ------------------------------------------------------------------------
+// filter kernels. output pixel x is centered between source pixels 2x and 2x + 1 and reads
+// source pixels 2x + first up to 2x + first + taps - 1. a dimension that is already 1 stays 1,
+// and the last column or row of an odd sized level is dropped, like GL mip level sizes.
+
+struct MipKernel {
+    int first;
+    int taps;
+    float weights[8];
+};
+
+inline double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 20; k++)
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+inline MipKernel mipKernel(MipFilter filter)
+{
+    MipKernel kernel = {};
+    if (filter == MIP_FILTER_BOX)
+    {
+        kernel.first = 0;
+        kernel.taps = 2;
+        kernel.weights[0] = kernel.weights[1] = 0.5f;
+        return kernel;
+    }
+    // sinc at the destination rate under a Kaiser window (beta 4) reaching 4 source pixels out
+    const double pi = 3.14159265358979323846, beta = 4.0, radius = 4.0;
+    kernel.first = -3;
+    kernel.taps = 8;
+    double weights[8], sum = 0.0;
+    for (int t = 0; t < kernel.taps; t++)
+    {
+        double distance = kernel.first + t - 0.5;
+        double s = distance / 2.0;
+        double r = distance / radius;
+        weights[t] = std::sin(pi * s) / (pi * s) * besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+        sum += weights[t];
+    }
+    for (int t = 0; t < kernel.taps; t++)
+        kernel.weights[t] = (float) (weights[t] / sum);
+    return kernel;
+}
+
+// ------------------------------------------------------------------------
+// 8 bit <-> float conversions
+
+const int MIP_SRGB_STEPS = 8192;
+
+struct SrgbTables {
+    float toLinear[256];
+    unsigned char fromLinear[MIP_SRGB_STEPS + 1];
+};
+
+inline const SrgbTables &srgbTables()
+{
+    static const SrgbTables tables = []() {
+        SrgbTables t;
+        for (int i = 0; i < 256; i++)
+        {
+            double c = i / 255.0;
+            t.toLinear[i] = (float) (c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i <= MIP_SRGB_STEPS; i++)
+        {
+            double l = (double) i / MIP_SRGB_STEPS;
+            double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+            t.fromLinear[i] = (unsigned char) std::lround(c * 255.0);
+        }
+        return t;
+    }();
+    return tables;
+}
+
+inline bool mipChannelIsSrgb(const MipOptions &options, int components, int channel)
+{
+    bool alpha = (components == 4 && channel == 3) || (components == 2 && channel == 1);
+    return options.srgb && !alpha;
+}
+
+inline float mipClamp01(float value)
+{
+    return std::min(1.0f, std::max(0.0f, value));
+}
+
+inline unsigned char mipEncodeLinear(float value)
+{
+    return (unsigned char) (mipClamp01(value) * 255.0f + 0.5f);
+}
+
+inline unsigned char mipEncodeSrgb(float value)
+{
+    return srgbTables().fromLinear[(int) (mipClamp01(value) * MIP_SRGB_STEPS + 0.5f)];
+}
+
+// ------------------------------------------------------------------------
+// span kernels, one set per instruction set. all spans are contiguous and unaligned.
+
+struct MipSpanKernels {
+    const char *name;
+    // dst[i] = weight * src[i]
+    void (*scale)(float *dst, const float *src, float weight, size_t count);
+    // dst[i] += weight * src[i]
+    void (*accumulate)(float *dst, const float *src, float weight, size_t count);
+    // bytes to [0, 1] and back, rounding and clamping; used for linear images
+    void (*unpack)(const unsigned char *src, float *dst, size_t count);
+    void (*pack)(const float *src, unsigned char *dst, size_t count);
+    // splits pairs of pixels into the even and the odd ones
+    void (*deinterleave)(const float *row, int pairs, int components, float *even, float *odd);
+};
+
+inline void mipScaleScalar(float *dst, const float *src, float weight, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = weight * src[i];
+}
+
+inline void mipAccumulateScalar(float *dst, const float *src, float weight, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] += weight * src[i];
+}
+
+inline void mipUnpackScalar(const unsigned char *src, float *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = src[i] * (1.0f / 255.0f);
+}
+
+inline void mipPackScalar(const float *src, unsigned char *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = mipEncodeLinear(src[i]);
+}
+
+inline void mipDeinterleaveScalar(const float *row, int pairs, int components, float *even, float *odd)
+{
+    for (int p = 0; p < pairs; p++)
+        for (int c = 0; c < components; c++)
+        {
+            even[p * components + c] = row[(2 * p) * components + c];
+            odd[p * components + c] = row[(2 * p + 1) * components + c];
+        }
+}
+
+#ifdef MIPMAP_SSE2
+inline void mipScaleSse2(float *dst, const float *src, float weight, size_t count)
+{
+    __m128 w = _mm_set1_ps(weight);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_mul_ps(w, _mm_loadu_ps(src + i)));
+    mipScaleScalar(dst + i, src + i, weight, count - i);
+}
+
+inline void mipAccumulateSse2(float *dst, const float *src, float weight, size_t count)
+{
+    __m128 w = _mm_set1_ps(weight);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i))));
+    mipAccumulateScalar(dst + i, src + i, weight, count - i);
+}
+
+inline void mipUnpackSse2(const unsigned char *src, float *dst, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+        _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+    }
+    mipUnpackScalar(src + i, dst + i, count - i);
+}
+
+inline __m128i mipRoundSse2(__m128 value)
+{
+    value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+inline void mipPackSse2(const float *src, unsigned char *dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = _mm_packs_epi32(mipRoundSse2(_mm_loadu_ps(src + i)), mipRoundSse2(_mm_loadu_ps(src + i + 4)));
+        __m128i b = _mm_packs_epi32(mipRoundSse2(_mm_loadu_ps(src + i + 8)), mipRoundSse2(_mm_loadu_ps(src + i + 12)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(a, b));
+    }
+    mipPackScalar(src + i, dst + i, count - i);
+}
+
+// R8 and RG8 split with shuffles, RGBA8 moves whole pixels; RGB8 pixels straddle vectors and
+// are copied one by one
+inline void mipDeinterleaveSse2(const float *row, int pairs, int components, float *even, float *odd)
+{
+    int p = 0;
+    if (components == 1)
+    {
+        for (; p + 4 <= pairs; p += 4)
+        {
+            __m128 a = _mm_loadu_ps(row + 2 * p);
+            __m128 b = _mm_loadu_ps(row + 2 * p + 4);
+            _mm_storeu_ps(even + p, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(odd + p, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+    else if (components == 2)
+    {
+        for (; p + 2 <= pairs; p += 2)
+        {
+            __m128 a = _mm_loadu_ps(row + 4 * p);
+            __m128 b = _mm_loadu_ps(row + 4 * p + 4);
+            _mm_storeu_ps(even + 2 * p, _mm_movelh_ps(a, b));
+            _mm_storeu_ps(odd + 2 * p, _mm_movehl_ps(b, a));
+        }
+    }
+    else if (components == 4)
+    {
+        for (; p < pairs; p++)
+        {
+            _mm_storeu_ps(even + 4 * p, _mm_loadu_ps(row + 8 * p));
+            _mm_storeu_ps(odd + 4 * p, _mm_loadu_ps(row + 8 * p + 4));
+        }
+    }
+    mipDeinterleaveScalar(row + 2 * p * components, pairs - p, components, even + p * components,
+                          odd + p * components);
+}
+#endif
+
+#ifdef MIPMAP_AVX2
+__attribute__((target("avx2,fma"))) inline void mipScaleAvx2(float *dst, const float *src, float weight, size_t count)
+{
+    __m256 w = _mm256_set1_ps(weight);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(w, _mm256_loadu_ps(src + i)));
+    mipScaleScalar(dst + i, src + i, weight, count - i);
+}
+
+__attribute__((target("avx2,fma"))) inline void mipAccumulateAvx2(float *dst, const float *src, float weight, size_t count)
+{
+    __m256 w = _mm256_set1_ps(weight);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(w, _mm256_loadu_ps(src + i), _mm256_loadu_ps(dst + i)));
+    mipAccumulateScalar(dst + i, src + i, weight, count - i);
+}
+
+__attribute__((target("avx2,fma"))) inline void mipUnpackAvx2(const unsigned char *src, float *dst, size_t count)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)), scale));
+    }
+    mipUnpackScalar(src + i, dst + i, count - i);
+}
+
+__attribute__((target("avx2,fma"))) inline void mipPackAvx2(const float *src, unsigned char *dst, size_t count)
+{
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(255.0f), half = _mm256_set1_ps(0.5f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), zero), one);
+        __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 8), zero), one);
+        __m256i ia = _mm256_cvttps_epi32(_mm256_fmadd_ps(a, scale, half));
+        __m256i ib = _mm256_cvttps_epi32(_mm256_fmadd_ps(b, scale, half));
+        // the packs work per 128 bit lane, the permute puts the 16 bytes back in order
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), bytes);
+    }
+    mipPackScalar(src + i, dst + i, count - i);
+}
+#endif
+
+inline const MipSpanKernels &mipKernelsScalar()
+{
+    static const MipSpanKernels kernels = {"scalar", mipScaleScalar, mipAccumulateScalar, mipUnpackScalar,
+                                           mipPackScalar, mipDeinterleaveScalar};
+    return kernels;
+}
+
+// every kernel set this build and CPU can run, scalar first
+inline std::vector<const MipSpanKernels *> mipKernelSets()
+{
+    std::vector<const MipSpanKernels *> sets;
+    sets.push_back(&mipKernelsScalar());
+#ifdef MIPMAP_SSE2
+    static const MipSpanKernels sse2 = {"sse2", mipScaleSse2, mipAccumulateSse2, mipUnpackSse2, mipPackSse2,
+                                        mipDeinterleaveSse2};
+    sets.push_back(&sse2);
+#endif
+#ifdef MIPMAP_AVX2
+    static const MipSpanKernels avx2 = {"avx2", mipScaleAvx2, mipAccumulateAvx2, mipUnpackAvx2, mipPackAvx2,
+#ifdef MIPMAP_SSE2
+                                        mipDeinterleaveSse2};
+#else
+                                        mipDeinterleaveScalar};
+#endif
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        sets.push_back(&avx2);
+#endif
+    return sets;
+}
+
+// the fastest kernel set available
+inline const MipSpanKernels &mipKernels()
+{
+    static const MipSpanKernels *best = mipKernelSets().back();
+    return *best;
+}
+
+// ------------------------------------------------------------------------
+// chain generation
+
+inline void mipDecodeLevel(const unsigned char *pixels, size_t count, int components, const MipOptions &options,
+                           const MipSpanKernels &kernels, float *out)
+{
+    kernels.unpack(pixels, out, count);
+    if (!options.srgb)
+        return;
+    const SrgbTables &tables = srgbTables();
+    for (int c = 0; c < components; c++)
+        if (mipChannelIsSrgb(options, components, c))
+            for (size_t i = c; i < count; i += components)
+                out[i] = tables.toLinear[pixels[i]];
+}
+
+inline void mipEncodeLevel(const float *level, size_t count, int components, const MipOptions &options,
+                           const MipSpanKernels &kernels, unsigned char *out)
+{
+    kernels.pack(level, out, count);
+    if (!options.srgb)
+        return;
+    const SrgbTables &tables = srgbTables();
+    for (int c = 0; c < components; c++)
+        if (mipChannelIsSrgb(options, components, c))
+            for (size_t i = c; i < count; i += components)
+                out[i] = tables.fromLinear[(int) (mipClamp01(level[i]) * MIP_SRGB_STEPS + 0.5f)];
+}
+
+// filters one float level down to the next
+// ------------------------------------------------------------------------
+inline void mipDownsample(const float *src, int width, int height, int components, const MipKernel &kernel,
+                          const MipSpanKernels &kernels, float *dst)
+{
+    const int pad = 4;  // pixels of border on either side of the even and odd rows, enough for 8 taps
+    int dstWidth = std::max(1, width / 2);
+    int dstHeight = std::max(1, height / 2);
+    size_t rowFloats = (size_t) width * components;
+    size_t dstRowFloats = (size_t) dstWidth * components;
+    std::vector<float> column(rowFloats);
+    std::vector<float> even((dstWidth + 2 * pad) * components), odd((dstWidth + 2 * pad) * components);
+
+    for (int y = 0; y < dstHeight; y++)
+    {
+        // vertical taps over whole rows
+        for (int t = 0; t < kernel.taps; t++)
+        {
+            int sy = std::min(height - 1, std::max(0, 2 * y + kernel.first + t));
+            const float *row = src + (size_t) sy * rowFloats;
+            if (t == 0)
+                kernels.scale(column.data(), row, kernel.weights[t], rowFloats);
+            else
+                kernels.accumulate(column.data(), row, kernel.weights[t], rowFloats);
+        }
+
+        // horizontal taps: even[p] holds source pixel 2p and odd[p] pixel 2p + 1, so every tap
+        // again reads a contiguous span
+        int pairs = width / 2;
+        kernels.deinterleave(column.data(), pairs, components, even.data() + pad * components,
+                             odd.data() + pad * components);
+        for (int p = -pad; p < dstWidth + pad; p++)
+        {
+            if (p >= 0 && p < pairs)
+                continue;
+            int se = std::min(width - 1, std::max(0, 2 * p));
+            int so = std::min(width - 1, std::max(0, 2 * p + 1));
+            for (int c = 0; c < components; c++)
+            {
+                even[(p + pad) * components + c] = column[se * components + c];
+                odd[(p + pad) * components + c] = column[so * components + c];
+            }
+        }
+        float *out = dst + (size_t) y * dstRowFloats;
+        for (int t = 0; t < kernel.taps; t++)
+        {
+            int d = kernel.first + t;
+            // floor division, d is negative for the taps left of the center
+            int shift = d >= 0 ? d / 2 : -((1 - d) / 2);
+            const float *source = (d & 1 ? odd.data() : even.data()) + (pad + shift) * components;
+            if (t == 0)
+                kernels.scale(out, source, kernel.weights[t], dstRowFloats);
+            else
+                kernels.accumulate(out, source, kernel.weights[t], dstRowFloats);
+        }
+    }
+}
+
+// builds every level below an 8 bit image with 1 to 4 components; levels[i] is mip level i + 1
+// ------------------------------------------------------------------------
+inline void generateMipChain(const unsigned char *pixels, int width, int height, int components,
+                             const MipOptions &options, std::vector<std::vector<unsigned char>> &levels,
+                             const MipSpanKernels &kernels = mipKernels())
+{
+    MipKernel kernel = mipKernel(options.filter);
+    levels.resize(mipLevelCount(width, height) - 1);
+    std::vector<float> current((size_t) width * height * components), next;
+    mipDecodeLevel(pixels, current.size(), components, options, kernels, current.data());
+    for (std::vector<unsigned char> &level : levels)
+    {
+        int dstWidth = std::max(1, width / 2);
+        int dstHeight = std::max(1, height / 2);
+        next.resize((size_t) dstWidth * dstHeight * components);
+        mipDownsample(current.data(), width, height, components, kernel, kernels, next.data());
+        level.resize(next.size());
+        mipEncodeLevel(next.data(), next.size(), components, options, kernels, level.data());
+        current.swap(next);
+        width = dstWidth;
+        height = dstHeight;
+    }
+}
+
+// straightforward scalar version of generateMipChain(), every output sample summed directly
+// over the 2D footprint; the optimized kernels must stay within one step of it
+// ------------------------------------------------------------------------
+inline void generateMipChainReference(const unsigned char *pixels, int width, int height, int components,
+                                      const MipOptions &options, std::vector<std::vector<unsigned char>> &levels)
+{
+    MipKernel kernel = mipKernel(options.filter);
+    const SrgbTables &tables = srgbTables();
+    levels.resize(mipLevelCount(width, height) - 1);
+    std::vector<float> current((size_t) width * height * components), next;
+    for (size_t i = 0; i < current.size(); i++)
+    {
+        bool srgb = mipChannelIsSrgb(options, components, (int) (i % components));
+        current[i] = srgb ? tables.toLinear[pixels[i]] : pixels[i] / 255.0f;
+    }
+    for (std::vector<unsigned char> &level : levels)
+    {
+        int dstWidth = std::max(1, width / 2);
+        int dstHeight = std::max(1, height / 2);
+        next.assign((size_t) dstWidth * dstHeight * components, 0.0f);
+        level.resize(next.size());
+        for (int y = 0; y < dstHeight; y++)
+            for (int x = 0; x < dstWidth; x++)
+                for (int c = 0; c < components; c++)
+                {
+                    float sum = 0.0f;
+                    for (int ty = 0; ty < kernel.taps; ty++)
+                        for (int tx = 0; tx < kernel.taps; tx++)
+                        {
+                            int sx = std::min(width - 1, std::max(0, 2 * x + kernel.first + tx));
+                            int sy = std::min(height - 1, std::max(0, 2 * y + kernel.first + ty));
+                            sum += kernel.weights[ty] * kernel.weights[tx] * current[((size_t) sy * width + sx) * components + c];
+                        }
+                    size_t i = ((size_t) y * dstWidth + x) * components + c;
+                    next[i] = sum;
+                    level[i] = mipChannelIsSrgb(options, components, c) ? mipEncodeSrgb(sum) : mipEncodeLinear(sum);
+                }
+        current.swap(next);
+        width = dstWidth;
+        height = dstHeight;
+    }
+}
+#endif
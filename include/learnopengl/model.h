@@ -6,25 +6,165 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <stb_image.h>
+#include <assimp/DefaultIOSystem.h>
 #include <assimp/Importer.hpp>
+#include <assimp/IOStream.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/asset_pack.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/hash.h>
+#include <learnopengl/image.h>
+#include <learnopengl/mapped_file.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/obj_loader.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_registry.h>
 
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false,
+                             TextureUsage usage = TEXTURE_USAGE_COLOR);
 
+// post processing applied on import; part of the mesh cache key, so changing it re-imports every model
+const unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
 
 
+// what turns a model file into MeshData
+enum ModelImporter {
+    MODEL_IMPORTER_AUTO = 0,    // Assimp, until --bench-obj shows the native reader matching it
+    MODEL_IMPORTER_ASSIMP,
+    MODEL_IMPORTER_OBJ          // the native reader of obj_loader.h, opt-in; only for .obj files
+};
+
+inline ModelImporter resolveModelImporter(const string &path, ModelImporter importer)
+{
+    bool obj = path.size() >= 4 && path.compare(path.size() - 4, 4, ".obj") == 0;
+    return importer == MODEL_IMPORTER_OBJ && obj ? MODEL_IMPORTER_OBJ : MODEL_IMPORTER_ASSIMP;
+}
+
+// a file Assimp reads out of the asset pack's mapping
+class AssetIOStream : public Assimp::IOStream
+{
+public:
+    explicit AssetIOStream(MappedFile &&file) : file(std::move(file))
+    {
+    }
+
+    size_t Read(void *buffer, size_t size, size_t count) override
+    {
+        if (size == 0)
+            return 0;
+        count = std::min(count, (file.size() - position) / size);
+        std::memcpy(buffer, file.data() + position, size * count);
+        position += size * count;
+        return count;
+    }
+
+    size_t Write(const void *, size_t, size_t) override
+    {
+        return 0;
+    }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        size_t base = origin == aiOrigin_SET ? 0 : origin == aiOrigin_CUR ? position : file.size();
+        if (offset > file.size() - base)
+            return aiReturn_FAILURE;
+        position = base + offset;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override { return position; }
+    size_t FileSize() const override { return file.size(); }
+    void Flush() override {}
+
+private:
+    MappedFile file;
+    size_t position = 0;
+};
+
+// lets Assimp (and the material libraries it opens on its own) read from the asset pack,
+// and from disk for everything the pack doesn't contain
+class AssetIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+    bool Exists(const char *path) const override
+    {
+        return AssetPack::instance().contains(path) || Assimp::DefaultIOSystem::Exists(path);
+    }
+
+    Assimp::IOStream *Open(const char *path, const char *mode = "rb") override
+    {
+        if (mode[0] == 'r' && AssetPack::instance().contains(path))
+            return new AssetIOStream(MappedFile(path));
+        return Assimp::DefaultIOSystem::Open(path, mode);
+    }
+};
+
+// how a model is imported and uploaded
+struct ModelLoadOptions {
+    ModelImporter importer = MODEL_IMPORTER_AUTO;
+    bool gamma = false;
+    VertexLayout layout = VERTEX_LAYOUT_FLOAT;
+    MeshResidency residency = MESH_RESIDENCY_KEEP;
+    // vertices closer than this are merged on import
+    WeldTolerance weldTolerance;
+};
+
+// what welding and optimizing did to one mesh of a model imported from its source
+struct MeshImportReport {
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    unsigned int triangles = 0;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// everything a model needs before it is uploaded. Model::parse fills it without touching
+// OpenGL, so it can run on a worker thread.
+struct ModelData {
+    // set by the caller before parsing; packed meshes are converted on the parsing thread
+    ModelImporter importer = MODEL_IMPORTER_AUTO;
+    VertexLayout layout = VERTEX_LAYOUT_FLOAT;
+    // what the meshes keep on the CPU after upload
+    MeshResidency residency = MESH_RESIDENCY_KEEP;
+    // false imports the source even if the cache is up to date, and rewrites the cache
+    bool readCache = true;
+    WeldTolerance weldTolerance;
+    string directory;
+    // what parse read from disk: the source and its material libraries, which are always hashed,
+    // and the cache if it was used
+    uint64_t bytesRead = 0;
+    vector<MeshData> meshes;
+    // one per mesh when the source was imported, empty when the cache was used (see --mesh-report)
+    vector<MeshImportReport> reports;
+    // keeps the mapped cache alive while the meshes point into it
+    MeshCacheReader cache;
+
+    ModelData()
+    {
+    }
+
+    explicit ModelData(const ModelLoadOptions &options)
+        : importer(options.importer), layout(options.layout), residency(options.residency),
+          weldTolerance(options.weldTolerance)
+    {
+    }
+};
+
 class Model
 {
 public:
@@ -35,9 +175,64 @@ public:
     bool gammaCorrection;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, VertexLayout layout = VERTEX_LAYOUT_FLOAT,
+          MeshResidency residency = MESH_RESIDENCY_KEEP) : gammaCorrection(gamma)
     {
-        loadModel(path);
+        ModelData data;
+        data.layout = layout;
+        data.residency = residency;
+        parse(path, data);
+        upload(data);
+    }
+
+    // builds the model from parsed data; must run on the thread owning the GL context.
+    // textures the caller already uploaded are passed in preloaded and are not loaded again; the
+    // model takes over one registry reference for each of them.
+    Model(ModelData &data, const vector<Texture> &preloaded, bool gamma = false) : textures_loaded(preloaded), gammaCorrection(gamma)
+    {
+        for (size_t i = 0; i < textures_loaded.size(); i++)
+            loadedIndex.insert(make_pair(textures_loaded[i].path, i));
+        upload(data);
+    }
+
+    // every entry of textures_loaded holds one reference in the TextureRegistry, dropped here, so
+    // textures no other model uses are deleted. destroy models while the context is current.
+    ~Model()
+    {
+        for (const Texture &texture : textures_loaded)
+            TextureRegistry::instance().release(texture.id);
+    }
+
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    // bytes of the meshes' buffers on the GPU
+    size_t bufferBytes() const
+    {
+        size_t bytes = 0;
+        for (const Mesh &mesh : meshes)
+            bytes += mesh.bufferBytes();
+        return bytes;
+    }
+
+    // bytes the meshes keep on the CPU
+    size_t residentBytes() const
+    {
+        size_t bytes = 0;
+        for (const Mesh &mesh : meshes)
+            bytes += mesh.residentBytes();
+        return bytes;
+    }
+
+    // object space bounding box of all meshes together
+    void bounds(glm::vec3 &boundsMin, glm::vec3 &boundsMax) const
+    {
+        boundsMin = boundsMax = glm::vec3(0.0f);
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            boundsMin = i ? glm::min(boundsMin, meshes[i].boundsMin) : meshes[i].boundsMin;
+            boundsMax = i ? glm::max(boundsMax, meshes[i].boundsMax) : meshes[i].boundsMax;
+        }
     }
 
     // draws the model, and thus all its meshes
@@ -47,33 +242,124 @@ public:
             meshes[i].Draw(shader);
     }
 
-    void SetShaderTextureNamePrefix(std::string prefix) {
-        for (Mesh& mesh: meshes) {
-            mesh.glslIdentifierPrefix = prefix;
+    // loads a model with supported ASSIMP extensions from file into data, without any GL calls.
+    // the first import writes <path>.cache; later runs map that file instead, as long as the source is unchanged.
+    static bool parse(string const &path, ModelData &data)
+    {
+        // retrieve the directory path of the filepath
+        data.directory = path.substr(0, path.find_last_of('/'));
+
+        // an OBJ's textures come from its material libraries, so they count as source as well
+        uint64_t sourceHash = 0;
+        uint64_t sourceSize = 0;
+        data.bytesRead = 0;
+        {
+            MappedFile source(path);
+            if (source.valid())
+            {
+                sourceHash = fnv1a64(source.data(), source.size());
+                sourceSize = source.size();
+                if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".obj") == 0)
+                    sourceHash = objMaterialLibraryHash(source.data(), source.size(), data.directory, sourceHash,
+                                                        data.bytesRead);
+            }
         }
+        data.bytesRead += sourceSize;
+        // the cache holds the welded and optimized meshes, so the tolerances and the version of the
+        // optimizer are part of the key. the importers don't produce identical vertices, so the one
+        // used is as well
+        ModelImporter importer = resolveModelImporter(path, data.importer);
+        string cachePath = path + ".cache";
+        uint64_t processing = fnv1a64(&MESH_OPTIMIZER_VERSION, sizeof(MESH_OPTIMIZER_VERSION));
+        processing = fnv1a64(&importer, sizeof(importer), processing);
+        uint32_t processingHash = (uint32_t) fnv1a64(&data.weldTolerance, sizeof(data.weldTolerance), processing);
+        if (data.readCache && data.cache.open(cachePath, sourceHash, sourceSize, MODEL_IMPORT_FLAGS, processingHash))
+        {
+            data.meshes.swap(data.cache.meshes);
+            data.bytesRead += data.cache.fileSize();
+            packMeshes(data);
+            return true;
+        }
+
+        bool imported = importer == MODEL_IMPORTER_OBJ ? loadObj(path, data.meshes) : importAssimp(path, data.meshes);
+        if (!imported)
+            return false;
+
+        // weld and reorder indices and vertices once here, the cache keeps the result
+        data.reports.assign(data.meshes.size(), MeshImportReport());
+        for (size_t i = 0; i < data.meshes.size(); i++)
+        {
+            MeshImportReport &report = data.reports[i];
+            report.verticesBefore = data.meshes[i].vertices.size();
+            report.verticesAfter = report.verticesBefore - weldVertices(data.meshes[i], data.weldTolerance);
+            optimizeMesh(data.meshes[i], report.before, report.after);
+            report.triangles = data.meshes[i].indexCount / 3;
+        }
+
+        if (!writeMeshCache(cachePath, data.meshes, sourceHash, sourceSize, MODEL_IMPORT_FLAGS, processingHash))
+            cout << "WARNING::MODEL:: could not write mesh cache " << cachePath << endl;
+        packMeshes(data);
+        return true;
     }
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+
+    // reads a file via ASSIMP into one MeshData per mesh, without any further processing
+    static bool importAssimp(string const &path, vector<MeshData> &meshes)
     {
-        // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        // the importer owns the handler and deletes it
+        if (AssetPack::instance().mounted())
+            importer.SetIOHandler(new AssetIOSystem());
+        const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        processNode(scene->mRootNode, scene, meshes);
+        return true;
+    }
+
+private:
+    // position of each path in textures_loaded
+    unordered_map<string, size_t> loadedIndex;
+
+    // the cache always holds the float layout, packing is cheap next to parsing
+    static void packMeshes(ModelData &data)
+    {
+        if (data.layout != VERTEX_LAYOUT_PACKED)
+            return;
+        for (MeshData &mesh : data.meshes)
+            mesh.pack();
+    }
+
+    // creates the GL side of every parsed mesh. meshes imported through Assimp hand their vectors
+    // over, meshes read from the cache are uploaded straight from the mapping; either way each
+    // mesh then keeps only what data.residency asks for.
+    void upload(ModelData &data)
+    {
+        directory = data.directory;
+        meshes.reserve(data.meshes.size());
+        for (MeshData &mesh : data.meshes)
+        {
+            vector<Texture> textures;
+            for (const TextureRef &texture : mesh.textures)
+                textures.push_back(findOrLoadTexture(texture.path, texture.type));
+            if (data.layout == VERTEX_LAYOUT_PACKED)
+                meshes.push_back(Mesh(mesh, std::move(textures), data.residency));
+            else if (!mesh.vertices.empty())
+                meshes.push_back(Mesh(std::move(mesh.vertices), std::move(mesh.indices), std::move(textures),
+                                      data.residency));
+            else
+                meshes.push_back(Mesh(mesh.vertexData, mesh.vertexCount, mesh.indexData, mesh.indexCount,
+                                      std::move(textures), mesh.boundsMin, mesh.boundsMax, data.residency));
+        }
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    static void processNode(aiNode *node, const aiScene *scene, vector<MeshData> &meshes)
     {
         // process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -86,17 +372,18 @@ private:
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, meshes);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    static MeshData processMesh(aiMesh *mesh, const aiScene *scene)
     {
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        MeshData data;
+        vector<Vertex> &vertices = data.vertices;
+        vector<unsigned int> &indices = data.indices;
+        vector<TextureRef> &textures = data.textures;
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -164,96 +451,67 @@ private:
 
 
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+        vector<TextureRef> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
         textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+        vector<TextureRef> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
         textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
+        std::vector<TextureRef> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
         textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+        std::vector<TextureRef> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
 
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return the mesh data; it is uploaded later, on the GL thread
+        data.useOwnedData();
+        return data;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    // collects the material textures of a given type; nothing is loaded yet
+    static vector<TextureRef> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
     {
-        vector<Texture> textures;
+        vector<TextureRef> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            TextureRef texture;
+            texture.type = typeName;
+            texture.path = str.C_Str();
+            textures.push_back(texture);
         }
         return textures;
     }
+
+    // returns the texture if it was loaded before for this model, gets it from the texture registry otherwise,
+    // so the model holds one registry reference per distinct texture
+    Texture findOrLoadTexture(const string &path, const string &typeName)
+    {
+        // check if texture was loaded before and if so, skip loading a new texture
+        auto found = loadedIndex.find(path);
+        if (found != loadedIndex.end())
+            return textures_loaded[found->second];
+        // if texture hasn't been loaded already, load it
+        Texture texture;
+        texture.id = TextureFromFile(path.c_str(), this->directory, false,
+                                     textureUsageFromSlot(textureSlotFromType(typeName)));
+        texture.type = typeName;
+        texture.path = path;
+        loadedIndex.insert(make_pair(path, textures_loaded.size()));
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+        return texture;
+    }
 };
 
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma, TextureUsage usage)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
+    return TextureRegistry::instance().acquire(filename, usage);
 }
 #endif
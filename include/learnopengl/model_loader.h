@@ -0,0 +1,282 @@
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <learnopengl/image.h>
+#include <learnopengl/model.h>
+#include <learnopengl/startup_trace.h>
+#include <learnopengl/texture_cooker.h>
+#include <learnopengl/texture_registry.h>
+#include <learnopengl/thread_pool.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// loads models and textures in parallel. Assimp parsing (or mapping the mesh cache) and image
+// loading (reading, cooking or decoding, see texture_cooker.h) run on the thread pool; every
+// finished job hands its result back to the context thread, where finish() does the GL uploads
+// in completion order. a model is uploaded as soon as its own textures are. images go through
+// the TextureRegistry: one that is already registered is not loaded at all, and one shared by
+// several assets of the batch is loaded once.
+//
+//     ModelLoader loader(pool);
+//     size_t ball = loader.addModel("ball.obj");
+//     size_t map = loader.addTexture("map.png");
+//     loader.finish();
+//     Model &model = loader.model(ball);
+//
+// models and textures stay owned by the loader, so it has to outlive them, and finish() must
+// be called before the loader goes away, since the queued jobs refer back to it.
+class ModelLoader
+{
+public:
+    explicit ModelLoader(ThreadPool &pool) : pool(pool)
+    {
+    }
+
+    ~ModelLoader()
+    {
+        unload();
+    }
+
+    ModelLoader(const ModelLoader &) = delete;
+    ModelLoader &operator=(const ModelLoader &) = delete;
+
+    // starts parsing a model and returns its handle
+    // ------------------------------------------------------------------------
+    size_t addModel(const std::string &path, const ModelLoadOptions &options = ModelLoadOptions())
+    {
+        size_t index = models.size();
+        models.push_back(std::unique_ptr<PendingModel>(new PendingModel()));
+        models[index]->path = path;
+        models[index]->gamma = options.gamma;
+        pool.submit([this, index, path, options]() {
+            std::shared_ptr<ModelData> data = std::make_shared<ModelData>(options);
+            {
+                StartupScope scope("model parse", path);
+                Model::parse(path, *data);
+                scope.bytesRead = data->bytesRead;
+            }
+            post([this, index, data]() { modelParsed(index, data); });
+        });
+        return index;
+    }
+
+    // starts loading a standalone texture and returns its handle
+    // ------------------------------------------------------------------------
+    size_t addTexture(const std::string &path, TextureUsage usage = TEXTURE_USAGE_COLOR)
+    {
+        std::string canonical = TextureRegistry::canonicalPath(path);
+        requestImage(canonical, usage, NO_MODEL);
+        textures.push_back(canonical);
+        textureIds.push_back(0);
+        return textures.size() - 1;
+    }
+
+    // uploads results as they arrive until every model and texture is on the GPU
+    // ------------------------------------------------------------------------
+    void finish()
+    {
+        while (!done())
+        {
+            std::function<void()> upload;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this]() { return !uploads.empty(); });
+                upload = std::move(uploads.front());
+                uploads.pop_front();
+            }
+            upload();
+        }
+        for (size_t i = 0; i < textures.size(); i++)
+            if (textureIds[i] == 0)
+                textureIds[i] = claim(textures[i]);
+    }
+
+    Model &model(size_t handle) { return *models[handle]->model; }
+    // the loader keeps the reference of a standalone texture until releaseTexture or unload
+    unsigned int texture(size_t handle) const { return textureIds[handle]; }
+
+    // drops the reference to a standalone texture; texture(handle) is 0 afterwards
+    // ------------------------------------------------------------------------
+    void releaseTexture(size_t handle)
+    {
+        if (textureIds[handle] != 0)
+            TextureRegistry::instance().release(textureIds[handle]);
+        textureIds[handle] = 0;
+    }
+
+    // destroys every model and releases every standalone texture, deleting the textures nothing
+    // else references. call it while the context is still current; the destructor only catches
+    // what is left.
+    // ------------------------------------------------------------------------
+    void unload()
+    {
+        for (std::unique_ptr<PendingModel> &model : models)
+            model->model.reset();
+        for (size_t i = 0; i < textureIds.size(); i++)
+            releaseTexture(i);
+    }
+
+private:
+    static const size_t NO_MODEL = (size_t) -1;
+
+    struct PendingModel {
+        std::string path;
+        bool gamma = false;
+        std::shared_ptr<ModelData> data;
+        size_t waitingImages = 0;
+        std::unique_ptr<Model> model;
+    };
+
+    struct PendingImage {
+        unsigned int id = 0;
+        bool uploaded = false;
+        bool claimed = false;  // the registry reference taken on upload was handed to a user
+        std::vector<size_t> waitingModels;
+    };
+
+    ThreadPool &pool;
+    std::vector<std::unique_ptr<PendingModel>> models;
+    std::vector<std::string> textures;
+    std::vector<unsigned int> textureIds;
+    // keyed by canonical path, only touched on the context thread
+    std::map<std::string, PendingImage> images;
+    size_t modelsUploaded = 0;
+    size_t imagesUploaded = 0;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> uploads;
+
+    // called from the workers; queues work for the context thread
+    void post(std::function<void()> upload)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            uploads.push_back(std::move(upload));
+        }
+        ready.notify_one();
+    }
+
+    bool done() const
+    {
+        return modelsUploaded == models.size() && imagesUploaded == images.size();
+    }
+
+    // returns true if the image is already uploaded, otherwise the model (if any) waits for it
+    bool requestImage(const std::string &path, TextureUsage usage, size_t modelIndex)
+    {
+        auto found = images.find(path);
+        if (found == images.end())
+        {
+            found = images.insert(std::make_pair(path, PendingImage())).first;
+            PendingImage &image = found->second;
+            if (TextureRegistry::instance().tryAcquire(path, image.id))
+            {
+                image.uploaded = true;
+                imagesUploaded++;
+                return true;
+            }
+            pool.submit([this, path, usage]() {
+                std::shared_ptr<Image> image = std::make_shared<Image>();
+                {
+                    StartupScope scope("texture load", path);
+                    loadTextureData(path, usage, *image);
+                    scope.bytesRead = image->bytesRead;
+                }
+                post([this, path, image]() { imageDecoded(path, *image); });
+            });
+        }
+        if (found->second.uploaded)
+            return true;
+        if (modelIndex != NO_MODEL)
+            found->second.waitingModels.push_back(modelIndex);
+        return false;
+    }
+
+    void modelParsed(size_t index, const std::shared_ptr<ModelData> &data)
+    {
+        PendingModel &model = *models[index];
+        model.data = data;
+        std::set<std::string> requested;
+        for (const MeshData &mesh : data->meshes)
+            for (const TextureRef &texture : mesh.textures)
+            {
+                std::string path = TextureRegistry::canonicalPath(data->directory + '/' + texture.path);
+                TextureUsage usage = textureUsageFromSlot(textureSlotFromType(texture.type));
+                if (requested.insert(path).second && !requestImage(path, usage, index))
+                    model.waitingImages++;
+            }
+        if (model.waitingImages == 0)
+            uploadModel(index);
+    }
+
+    void imageDecoded(const std::string &path, const Image &image)
+    {
+        PendingImage &pending = images[path];
+        if (!image.loaded())
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+        {
+            // a file with the same contents as a registered one is shared, not uploaded
+            StartupScope scope("texture upload", path);
+            size_t uploadedBefore = TextureRegistry::instance().statistics().bytesUploaded;
+            pending.id = TextureRegistry::instance().add(path, image);
+            scope.bytesUploaded = TextureRegistry::instance().statistics().bytesUploaded - uploadedBefore;
+        }
+        pending.uploaded = true;
+        imagesUploaded++;
+        for (size_t index : pending.waitingModels)
+            if (--models[index]->waitingImages == 0)
+                uploadModel(index);
+        pending.waitingModels.clear();
+    }
+
+    void uploadModel(size_t index)
+    {
+        PendingModel &model = *models[index];
+        ModelData &data = *model.data;
+        // hand the uploaded textures to the model under the relative paths its meshes use,
+        // taking one registry reference per distinct texture for it
+        std::vector<Texture> preloaded;
+        std::set<std::string> claimed;
+        for (const MeshData &mesh : data.meshes)
+            for (const TextureRef &ref : mesh.textures)
+            {
+                if (!claimed.insert(ref.path).second)
+                    continue;
+                Texture texture;
+                texture.id = claim(TextureRegistry::canonicalPath(data.directory + '/' + ref.path));
+                texture.type = ref.type;
+                texture.path = ref.path;
+                preloaded.push_back(texture);
+            }
+        StartupScope scope("model upload", model.path);
+        model.model.reset(new Model(data, preloaded, model.gamma));
+        scope.bytesUploaded = model.model->bufferBytes();
+        model.data = nullptr;
+        modelsUploaded++;
+    }
+
+    // the first user of an image gets the reference taken when it was registered,
+    // every further user takes its own
+    unsigned int claim(const std::string &path)
+    {
+        PendingImage &image = images[path];
+        if (!image.claimed)
+        {
+            image.claimed = true;
+            return image.id;
+        }
+        unsigned int id = image.id;
+        TextureRegistry::instance().tryAcquire(path, id);
+        return id;
+    }
+};
+#endif
@@ -0,0 +1,520 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define OBJ_LOADER_SSE2 1
+#endif
+
+// native reader for the Wavefront OBJ/MTL files Blender exports, the alternative to Assimp for
+// the .obj files in resources/objects (see ModelImporter in model.h).
+//
+// the file is mapped and walked line by line, newlines found 16 bytes at a time, numbers are
+// parsed in place, and every face corner goes straight into the vertex and index arrays of a
+// MeshData, one vertex per distinct v/vt/vn triple. the result matches what Model gets from
+// Assimp with MODEL_IMPORT_FLAGS:
+//   - one mesh per object and material, in file order
+//   - polygons triangulated as fans
+//   - texture coordinates flipped vertically
+//   - smooth normals generated where faces have none
+//   - tangents and bitangents computed per vertex with the formula of Assimp's CalcTangentSpace,
+//     after the flip, since Assimp runs FlipUVs first
+// understood are v, vt, vn, f, o, g, usemtl and mtllib, and in the MTL file newmtl, map_Kd,
+// map_Ks, map_Bump (or bump) and map_Ka; everything else is skipped.
+
+// ------------------------------------------------------------------------
+// line scanning and number parsing
+
+// first '\n' in [p, end), or end
+inline const char *objFindNewline(const char *p, const char *end)
+{
+#if OBJ_LOADER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16)
+    {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), newline));
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '\n')
+        p++;
+    return p;
+}
+
+inline void objSkipSpaces(const char *&p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+}
+
+inline bool objIsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// decimal float with optional sign, fraction and exponent. up to 19 significant digits are kept
+// in an integer and scaled once, which is exact for everything an exporter writes.
+inline float objParseFloat(const char *&p, const char *end)
+{
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    objSkipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    for (; p < end && objIsDigit(*p); p++)
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+            exponent++;
+    if (p < end && *p == '.')
+        for (p++; p < end && objIsDigit(*p); p++)
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExponent = *p++ == '-';
+        int value = 0;
+        for (; p < end && objIsDigit(*p); p++)
+            value = std::min(value * 10 + (*p - '0'), 1000);
+        exponent += negativeExponent ? -value : value;
+    }
+
+    double result = (double) mantissa;
+    if (exponent >= -22 && exponent <= 22)
+        result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+    else
+        result *= std::pow(10.0, exponent);
+    return (float) (negative ? -result : result);
+}
+
+inline int objParseInt(const char *&p, const char *end)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    int value = 0;
+    for (; p < end && objIsDigit(*p); p++)
+        value = value * 10 + (*p - '0');
+    return negative ? -value : value;
+}
+
+// the rest of the line without surrounding whitespace
+inline std::string objRestOfLine(const char *p, const char *end)
+{
+    objSkipSpaces(p, end);
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        end--;
+    return std::string(p, end);
+}
+
+// checks for a keyword followed by whitespace and moves past it
+inline bool objKeyword(const char *&p, const char *end, const char *keyword)
+{
+    size_t length = std::strlen(keyword);
+    if ((size_t) (end - p) < length || std::memcmp(p, keyword, length) != 0)
+        return false;
+    if (p + length < end && p[length] != ' ' && p[length] != '\t')
+        return false;
+    p += length;
+    return true;
+}
+
+// the file name of an MTL map statement: the rest of the line after the options, so names with
+// spaces survive. -o, -s and -t take one to three numbers, the other options a fixed count.
+inline std::string objTextureFileName(const char *p, const char *end)
+{
+    static const struct {
+        const char *name;
+        int arguments;
+    } options[] = {{"-blendu", 1}, {"-blendv", 1}, {"-bm", 1}, {"-boost", 1}, {"-cc", 1}, {"-clamp", 1},
+                   {"-imfchan", 1}, {"-mm", 2}, {"-o", 3}, {"-s", 3}, {"-t", 3}, {"-texres", 1}};
+    while (true)
+    {
+        objSkipSpaces(p, end);
+        int arguments = -1;
+        for (const auto &option : options)
+            if (objKeyword(p, end, option.name))
+            {
+                arguments = option.arguments;
+                break;
+            }
+        if (arguments < 0)
+            return objRestOfLine(p, end);
+        for (int i = 0; i < arguments; i++)
+        {
+            objSkipSpaces(p, end);
+            const char *word = p;
+            bool number = true;
+            for (; p < end && *p != ' ' && *p != '\t'; p++)
+                number = number && (objIsDigit(*p) || std::strchr("+-.eE", *p));
+            // the optional numbers of -o, -s and -t end at the first word that isn't one
+            if (i > 0 && !number)
+            {
+                p = word;
+                break;
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// materials
+
+// the textures of every material in an MTL file, ordered like Model::processMesh orders Assimp's
+inline std::unordered_map<std::string, std::vector<TextureRef>> loadObjMaterials(const std::string &path)
+{
+    std::unordered_map<std::string, std::vector<TextureRef>> materials;
+    MappedFile file(path);
+    if (!file.valid())
+    {
+        std::cout << "WARNING::OBJ:: could not open material library " << path << std::endl;
+        return materials;
+    }
+
+    // the MTL keys, and the sampler types Model gives Assimp's texture types they end up as
+    static const struct {
+        const char *key;
+        const char *type;
+    } maps[] = {{"map_Kd", "texture_diffuse"}, {"map_Ks", "texture_specular"}, {"map_Bump", "texture_normal"},
+                {"bump", "texture_normal"}, {"map_Ka", "texture_height"}};
+    const int mapCount = sizeof(maps) / sizeof(maps[0]);
+
+    std::vector<std::string> found[mapCount];
+    std::string name;
+    bool open = false;
+    auto flush = [&]() {
+        if (!open)
+            return;
+        std::vector<TextureRef> &textures = materials[name];
+        for (int i = 0; i < mapCount; i++)
+        {
+            for (const std::string &texture : found[i])
+                textures.push_back(TextureRef{maps[i].type, texture});
+            found[i].clear();
+        }
+    };
+
+    const char *p = reinterpret_cast<const char *>(file.data());
+    const char *end = p + file.size();
+    while (p < end)
+    {
+        const char *lineEnd = objFindNewline(p, end);
+        const char *q = p;
+        objSkipSpaces(q, lineEnd);
+        if (objKeyword(q, lineEnd, "newmtl"))
+        {
+            flush();
+            name = objRestOfLine(q, lineEnd);
+            open = true;
+        }
+        else
+            for (int i = 0; i < mapCount; i++)
+                if (objKeyword(q, lineEnd, maps[i].key))
+                {
+                    found[i].push_back(objTextureFileName(q, lineEnd));
+                    break;
+                }
+        p = lineEnd + 1;
+    }
+    flush();
+    return materials;
+}
+
+// ------------------------------------------------------------------------
+// geometry
+
+// the mesh being filled. vertices are shared per v/vt/vn triple: the vertices of a position
+// form a chain through next, starting at head[position] when headMesh[position] is this mesh.
+struct ObjMeshBuilder {
+    MeshData data;
+    std::vector<int> texCoordIndex;
+    std::vector<int> normalIndex;
+    std::vector<unsigned int> positionIndex;
+    std::vector<unsigned int> next;
+    bool hasNormals = true;
+};
+
+class ObjReader
+{
+public:
+    bool read(const std::string &path, std::vector<MeshData> &meshes)
+    {
+        MappedFile file(path);
+        if (!file.valid())
+        {
+            std::cout << "ERROR::OBJ:: could not open " << path << std::endl;
+            return false;
+        }
+        directory = path.substr(0, path.find_last_of('/'));
+
+        const char *p = reinterpret_cast<const char *>(file.data());
+        const char *end = p + file.size();
+        while (p < end)
+        {
+            const char *lineEnd = objFindNewline(p, end);
+            parseLine(p, lineEnd);
+            p = lineEnd + 1;
+        }
+        finishMesh();
+        meshes = std::move(this->meshes);
+        return true;
+    }
+
+private:
+    std::string directory;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::unordered_map<std::string, std::vector<TextureRef>> materials;
+    std::vector<TextureRef> material;
+    std::vector<unsigned int> head;
+    std::vector<unsigned int> headMesh;
+    std::vector<unsigned int> corners;
+    // tells the chains of the current mesh from stale ones
+    unsigned int meshSerial = 1;
+    ObjMeshBuilder mesh;
+    std::vector<MeshData> meshes;
+
+    void parseLine(const char *p, const char *end)
+    {
+        objSkipSpaces(p, end);
+        if (p + 1 >= end)
+            return;
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            p += 2;
+            float x = objParseFloat(p, end), y = objParseFloat(p, end), z = objParseFloat(p, end);
+            positions.push_back(glm::vec3(x, y, z));
+        }
+        else if (p[0] == 'v' && p[1] == 't')
+        {
+            p += 2;
+            float u = objParseFloat(p, end), v = objParseFloat(p, end);
+            texCoords.push_back(glm::vec2(u, v));
+        }
+        else if (p[0] == 'v' && p[1] == 'n')
+        {
+            p += 2;
+            float x = objParseFloat(p, end), y = objParseFloat(p, end), z = objParseFloat(p, end);
+            normals.push_back(glm::vec3(x, y, z));
+        }
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+            parseFace(p + 2, end);
+        else if (objKeyword(p, end, "o") || objKeyword(p, end, "g"))
+            finishMesh();
+        else if (objKeyword(p, end, "usemtl"))
+        {
+            finishMesh();
+            auto found = materials.find(objRestOfLine(p, end));
+            material = found != materials.end() ? found->second : std::vector<TextureRef>();
+        }
+        else if (objKeyword(p, end, "mtllib"))
+            materials = loadObjMaterials(directory + '/' + objRestOfLine(p, end));
+    }
+
+    // OBJ indices are 1 based, negative ones count back from the last element read so far
+    static int resolveIndex(int index, size_t count)
+    {
+        return index > 0 ? index - 1 : index < 0 ? (int) count + index : -1;
+    }
+
+    void parseFace(const char *p, const char *end)
+    {
+        corners.clear();
+        while (true)
+        {
+            objSkipSpaces(p, end);
+            if (p >= end || !(objIsDigit(*p) || *p == '-'))
+                break;
+            int position = resolveIndex(objParseInt(p, end), positions.size());
+            int texCoord = -1, normal = -1;
+            if (p < end && *p == '/')
+            {
+                p++;
+                if (p < end && *p != '/')
+                    texCoord = resolveIndex(objParseInt(p, end), texCoords.size());
+                if (p < end && *p == '/')
+                {
+                    p++;
+                    normal = resolveIndex(objParseInt(p, end), normals.size());
+                }
+            }
+            if (position < 0 || (size_t) position >= positions.size())
+                return;
+            if ((size_t) texCoord >= texCoords.size())
+                texCoord = -1;
+            if ((size_t) normal >= normals.size())
+                normal = -1;
+            corners.push_back(vertexFor(position, texCoord, normal));
+        }
+        for (size_t i = 2; i < corners.size(); i++)
+        {
+            mesh.data.indices.push_back(corners[0]);
+            mesh.data.indices.push_back(corners[i - 1]);
+            mesh.data.indices.push_back(corners[i]);
+        }
+    }
+
+    unsigned int vertexFor(int position, int texCoord, int normal)
+    {
+        const unsigned int none = ~0u;
+        if (head.size() < positions.size())
+        {
+            head.resize(positions.size(), none);
+            headMesh.resize(positions.size(), 0);
+        }
+        if (headMesh[position] != meshSerial)
+        {
+            headMesh[position] = meshSerial;
+            head[position] = none;
+        }
+        for (unsigned int v = head[position]; v != none; v = mesh.next[v])
+            if (mesh.texCoordIndex[v] == texCoord && mesh.normalIndex[v] == normal)
+                return v;
+
+        Vertex vertex;
+        vertex.Position = positions[position];
+        vertex.Normal = normal >= 0 ? normals[normal] : glm::vec3(0.0f);
+        vertex.TexCoords = texCoord >= 0 ? texCoords[texCoord] : glm::vec2(0.0f);
+        vertex.Tangent = glm::vec3(0.0f);
+        vertex.Bitangent = glm::vec3(0.0f);
+        mesh.hasNormals = mesh.hasNormals && normal >= 0;
+
+        unsigned int index = mesh.data.vertices.size();
+        mesh.data.vertices.push_back(vertex);
+        mesh.texCoordIndex.push_back(texCoord);
+        mesh.normalIndex.push_back(normal);
+        mesh.positionIndex.push_back(position);
+        mesh.next.push_back(head[position]);
+        head[position] = index;
+        return index;
+    }
+
+    void finishMesh()
+    {
+        MeshData &data = mesh.data;
+        if (!data.indices.empty())
+        {
+            for (Vertex &vertex : data.vertices)
+                vertex.TexCoords.y = 1.0f - vertex.TexCoords.y;
+            if (!mesh.hasNormals)
+                generateNormals();
+            generateTangents();
+            data.textures = material;
+            data.useOwnedData();
+            meshes.push_back(std::move(data));
+        }
+        mesh = ObjMeshBuilder();
+        meshSerial++;
+    }
+
+    // unit face normals averaged over every vertex at the same position, for the vertices whose
+    // faces had no vn. like GenSmoothNormals, every face counts the same whatever its area.
+    void generateNormals()
+    {
+        std::vector<Vertex> &vertices = mesh.data.vertices;
+        const std::vector<unsigned int> &indices = mesh.data.indices;
+        std::unordered_map<unsigned int, glm::vec3> sums;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            glm::vec3 normal = normalizeOrZero(glm::cross(vertices[b].Position - vertices[a].Position,
+                                                          vertices[c].Position - vertices[a].Position));
+            for (unsigned int v : {a, b, c})
+                if (mesh.normalIndex[v] < 0)
+                    sums[mesh.positionIndex[v]] += normal;
+        }
+        for (size_t v = 0; v < vertices.size(); v++)
+            if (mesh.normalIndex[v] < 0)
+            {
+                glm::vec3 sum = sums[mesh.positionIndex[v]];
+                float length = glm::length(sum);
+                vertices[v].Normal = length > 0.0f ? sum / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+    }
+
+    // the face tangent frame of Assimp's CalcTangentSpace, made orthogonal to each corner's
+    // normal, summed per vertex and normalized
+    void generateTangents()
+    {
+        std::vector<Vertex> &vertices = mesh.data.vertices;
+        const std::vector<unsigned int> &indices = mesh.data.indices;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const Vertex &v0 = vertices[indices[i]];
+            const Vertex &v1 = vertices[indices[i + 1]];
+            const Vertex &v2 = vertices[indices[i + 2]];
+            glm::vec3 dp1 = v1.Position - v0.Position, dp2 = v2.Position - v0.Position;
+            float sx = v1.TexCoords.x - v0.TexCoords.x, sy = v1.TexCoords.y - v0.TexCoords.y;
+            float tx = v2.TexCoords.x - v0.TexCoords.x, ty = v2.TexCoords.y - v0.TexCoords.y;
+            float direction = tx * sy - ty * sx < 0.0f ? -1.0f : 1.0f;
+            if (sx * ty == sy * tx)
+            {
+                sx = 0.0f; sy = 1.0f;
+                tx = 1.0f; ty = 0.0f;
+            }
+            glm::vec3 tangent = (dp2 * sy - dp1 * ty) * direction;
+            glm::vec3 bitangent = (dp2 * sx - dp1 * tx) * direction;
+            for (int corner = 0; corner < 3; corner++)
+            {
+                Vertex &vertex = vertices[indices[i + corner]];
+                vertex.Tangent += orthogonalize(tangent, vertex.Normal);
+                vertex.Bitangent += orthogonalize(bitangent, vertex.Normal);
+            }
+        }
+        for (Vertex &vertex : vertices)
+        {
+            vertex.Tangent = normalizeOrZero(vertex.Tangent);
+            vertex.Bitangent = normalizeOrZero(vertex.Bitangent);
+        }
+    }
+
+    static glm::vec3 orthogonalize(const glm::vec3 &v, const glm::vec3 &normal)
+    {
+        return normalizeOrZero(v - normal * glm::dot(v, normal));
+    }
+
+    static glm::vec3 normalizeOrZero(const glm::vec3 &v)
+    {
+        float length = glm::length(v);
+        return length > 0.0f ? v / length : glm::vec3(0.0f);
+    }
+};
+
+// reads an OBJ file into one MeshData per object and material; false if it can't be opened
+inline bool loadObj(const std::string &path, std::vector<MeshData> &meshes)
+{
+    ObjReader reader;
+    return reader.read(path, meshes);
+}
+#endif
@@ -0,0 +1,285 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include "imgui.h"
+
+#include <learnopengl/gl_state.h>
+#include <learnopengl/texture_registry.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// the last SAMPLE_COUNT values of one measurement, with the statistics shown in the overlay
+class RollingStats
+{
+public:
+    static const unsigned int SAMPLE_COUNT = 120;
+
+    // ------------------------------------------------------------------------
+    void push(float value)
+    {
+        samples[next] = value;
+        next = (next + 1) % SAMPLE_COUNT;
+        if (count < SAMPLE_COUNT)
+            count++;
+    }
+
+    unsigned int size() const { return count; }
+
+    // ------------------------------------------------------------------------
+    float average() const
+    {
+        if (count == 0)
+            return 0.0f;
+        float sum = 0.0f;
+        for (unsigned int i = 0; i < count; i++)
+            sum += samples[i];
+        return sum / count;
+    }
+
+    // p in [0, 1]; nearest-rank percentile over the stored samples
+    // ------------------------------------------------------------------------
+    float percentile(float p) const
+    {
+        if (count == 0)
+            return 0.0f;
+        std::vector<float> sorted(samples, samples + count);
+        unsigned int rank = std::min(count - 1, (unsigned int) (p * (count - 1) + 0.5f));
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+
+private:
+    float samples[SAMPLE_COUNT] = {};
+    unsigned int next = 0;
+    unsigned int count = 0;
+};
+
+// per-frame CPU and GPU timings of named sections.
+//
+// CPU time is measured with std::chrono around begin()/end(). GPU time uses GL_TIME_ELAPSED
+// queries taken from a per-frame pool; the pools form a ring of FRAME_LATENCY frames, so
+// results are read FRAME_LATENCY - 1 frames later and the CPU never waits for the GPU.
+// a section may be entered several times per frame and its times are summed. GPU timed
+// sections must not nest, as only one GL_TIME_ELAPSED query can be active at a time.
+class Profiler
+{
+public:
+    static const unsigned int FRAME_LATENCY = 4;
+
+    struct Section {
+        std::string name;
+        RollingStats cpu;  // milliseconds
+        RollingStats gpu;  // milliseconds
+        double cpuFrame = 0.0;
+        bool cpuUsed = false;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::vector<Section> sections;
+    RollingStats frameTime;  // milliseconds between two beginFrame() calls
+
+    Profiler()
+    {
+        for (unsigned int i = 0; i < FRAME_LATENCY; i++)
+            pools[i].queryCount = 0;
+    }
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    // ------------------------------------------------------------------------
+    int addSection(const std::string &name)
+    {
+        Section section;
+        section.name = name;
+        sections.push_back(section);
+        return sections.size() - 1;
+    }
+
+    // finishes the previous frame and collects the GPU results of the oldest frame in the ring
+    // ------------------------------------------------------------------------
+    void beginFrame()
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (frameCount > 0)
+        {
+            frameTime.push(milliseconds(frameStart, now));
+            for (Section &section : sections)
+            {
+                if (section.cpuUsed)
+                    section.cpu.push(section.cpuFrame);
+                section.cpuFrame = 0.0;
+                section.cpuUsed = false;
+            }
+        }
+        frameStart = now;
+        frameCount++;
+
+        QueryPool &pool = pools[frameCount % FRAME_LATENCY];
+        collect(pool);
+        pool.queryCount = 0;
+        pool.sections.clear();
+    }
+
+    // ------------------------------------------------------------------------
+    void begin(int section, bool gpu = true)
+    {
+        if (section < 0)
+            return;
+        sections[section].start = std::chrono::steady_clock::now();
+        if (gpu && gpuSection < 0)
+        {
+            gpuSection = section;
+            glBeginQuery(GL_TIME_ELAPSED, nextQuery(section));
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    void end(int section)
+    {
+        if (section < 0)
+            return;
+        if (gpuSection == section)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            gpuSection = -1;
+        }
+        Section &s = sections[section];
+        s.cpuFrame += milliseconds(s.start, std::chrono::steady_clock::now());
+        s.cpuUsed = true;
+    }
+
+    // ImGui window with rolling averages and percentiles of every section, the GL state counters
+    // and the texture registry statistics
+    // ------------------------------------------------------------------------
+    void drawOverlay() const
+    {
+        ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowBgAlpha(0.75f);
+        ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+        float frameMs = frameTime.average();
+        ImGui::Text("frame %.2f ms (%.0f fps), p95 %.2f ms", frameMs, frameMs > 0.0f ? 1000.0f / frameMs : 0.0f,
+                    frameTime.percentile(0.95f));
+
+        if (ImGui::BeginTable("sections", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            const char *headers[] = {"section", "cpu avg", "cpu p50", "cpu p95", "gpu avg", "gpu p50", "gpu p95"};
+            for (const char *header : headers)
+                ImGui::TableSetupColumn(header);
+            ImGui::TableHeadersRow();
+            for (const Section &section : sections)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(section.name.c_str());
+                statsColumns(section.cpu);
+                statsColumns(section.gpu);
+            }
+            ImGui::EndTable();
+        }
+
+        const GLStateStats &state = GLState::lastFrame();
+        ImGui::Text("GL state calls: %u issued, %u skipped", state.totalIssued(), state.totalSkipped());
+        for (unsigned int i = 0; i < GL_STATE_CALL_COUNT; i++)
+            ImGui::BulletText("%s: %u / %u", GLStateStats::name((GLStateCall) i), state.issued[i], state.skipped[i]);
+
+        const TextureRegistryStats &textures = TextureRegistry::instance().statistics();
+        ImGui::Text("textures: %u requests, %u hits (%u by content), %u uploads", textures.requests, textures.hits,
+                    textures.contentHits, textures.uploads);
+        ImGui::Text("texture memory: %.1f MB uploaded, %.1f MB saved", textures.bytesUploaded / 1048576.0,
+                    textures.bytesSaved / 1048576.0);
+
+        ImGui::End();
+    }
+
+private:
+    struct QueryPool {
+        std::vector<GLuint> queries;
+        std::vector<int> sections;
+        unsigned int queryCount;
+    };
+
+    QueryPool pools[FRAME_LATENCY];
+    unsigned int frameCount = 0;
+    int gpuSection = -1;
+    std::chrono::steady_clock::time_point frameStart;
+
+    // ------------------------------------------------------------------------
+    GLuint nextQuery(int section)
+    {
+        QueryPool &pool = pools[frameCount % FRAME_LATENCY];
+        if (pool.queryCount == pool.queries.size())
+        {
+            GLuint query;
+            glGenQueries(1, &query);
+            pool.queries.push_back(query);
+        }
+        pool.sections.push_back(section);
+        return pool.queries[pool.queryCount++];
+    }
+
+    // sums the GPU times of a finished frame per section. if the GPU is more than
+    // FRAME_LATENCY frames behind, the frame is dropped instead of stalling
+    // ------------------------------------------------------------------------
+    void collect(const QueryPool &pool)
+    {
+        if (pool.queryCount == 0)
+            return;
+        GLint available = 0;
+        glGetQueryObjectiv(pool.queries[pool.queryCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+
+        std::vector<double> totals(sections.size(), -1.0);
+        for (unsigned int i = 0; i < pool.queryCount; i++)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(pool.queries[i], GL_QUERY_RESULT, &elapsed);
+            double &total = totals[pool.sections[i]];
+            total = std::max(total, 0.0) + elapsed / 1.0e6;
+        }
+        for (unsigned int i = 0; i < sections.size(); i++)
+            if (totals[i] >= 0.0)
+                sections[i].gpu.push(totals[i]);
+    }
+
+    static void statsColumns(const RollingStats &stats)
+    {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.average());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.percentile(0.5f));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", stats.percentile(0.95f));
+    }
+
+    static float milliseconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<float, std::milli>(to - from).count();
+    }
+};
+
+// times the enclosing scope on the CPU (and optionally on the GPU)
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler &profiler, int section, bool gpu = false) : profiler(profiler), section(section)
+    {
+        profiler.begin(section, gpu);
+    }
+    ~ProfileScope()
+    {
+        profiler.end(section);
+    }
+
+private:
+    Profiler &profiler;
+    int section;
+};
+#endif
@@ -0,0 +1,175 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <sys/stat.h>
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// linked programs saved with glGetProgramBinary, one file per program, so later launches skip
+// compiling and linking. a binary is only good for the driver that produced it, so the key covers
+// the sources, the preprocessor defines and the vendor, renderer and version strings, and it is
+// stored in full in the file and compared on load. anything that doesn't match, or a binary the
+// driver refuses, just means the program is built from source again and the file replaced.
+//
+//     | header | key | binary |
+//
+// the directory is a per-machine cache, kept out of resources/ so the asset pack never holds it.
+const char PROGRAM_CACHE_MAGIC[4] = {'L', 'P', 'R', 'G'};
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t keySize;
+    uint64_t binarySize;
+};
+
+class ProgramCache
+{
+public:
+    static ProgramCache &instance()
+    {
+        static ProgramCache cache;
+        return cache;
+    }
+
+    ProgramCache(const ProgramCache &) = delete;
+    ProgramCache &operator=(const ProgramCache &) = delete;
+
+    // where binaries are kept; the cache is off until a directory is set
+    void setDirectory(const std::string &path)
+    {
+        directory = path;
+    }
+
+    // needs a directory and a context that can hand out program binaries
+    bool enabled() const
+    {
+        return !directory.empty() && glExtensions().programBinary;
+    }
+
+    // identifies one program on the current driver; sourceHash covers every stage's source
+    // ------------------------------------------------------------------------
+    std::string key(uint64_t sourceHash, const std::string &defines)
+    {
+        if (driver.empty())
+            driver = glString(GL_VENDOR) + " | " + glString(GL_RENDERER) + " | " + glString(GL_VERSION);
+        char prefix[64];
+        std::snprintf(prefix, sizeof(prefix), "v%u source=%016llx", PROGRAM_CACHE_VERSION,
+                      (unsigned long long) sourceHash);
+        return std::string(prefix) + " defines=" + defines + " driver=" + driver;
+    }
+
+    // asks the driver to link program before it is linked from source, or the binary may not be
+    // retrievable afterwards
+    // ------------------------------------------------------------------------
+    void prepare(GLuint program) const
+    {
+        if (enabled())
+            glExtensions().programParameteriProc(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // loads the saved binary for key into program. false leaves program unlinked; create a
+    // fresh one to build from source.
+    // ------------------------------------------------------------------------
+    bool load(GLuint program, const std::string &key, uint64_t &bytesRead) const
+    {
+        if (!enabled())
+            return false;
+        MappedFile file(path(key));
+        if (!file.valid() || file.size() < sizeof(ProgramCacheHeader))
+            return false;
+        ProgramCacheHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        const unsigned char *stored = file.data() + sizeof(header);
+        if (std::memcmp(header.magic, PROGRAM_CACHE_MAGIC, 4) != 0 || header.version != PROGRAM_CACHE_VERSION ||
+            header.keySize != key.size() || sizeof(header) + header.keySize + header.binarySize != file.size() ||
+            std::memcmp(stored, key.data(), key.size()) != 0)
+            return false;
+
+        glExtensions().programBinaryProc(program, header.binaryFormat, stored + header.keySize,
+                                         (GLsizei) header.binarySize);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked)
+            bytesRead += file.size();
+        return linked == GL_TRUE;
+    }
+
+    // saves a program linked from source after prepare(); false if nothing was written
+    // ------------------------------------------------------------------------
+    bool save(GLuint program, const std::string &key) const
+    {
+        if (!enabled())
+            return false;
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return false;
+        std::vector<unsigned char> binary(length);
+        GLsizei written = 0;
+        GLenum format = 0;
+        glExtensions().getProgramBinaryProc(program, length, &written, &format, binary.data());
+        if (written <= 0)
+            return false;
+
+        ProgramCacheHeader header = {};
+        std::memcpy(header.magic, PROGRAM_CACHE_MAGIC, 4);
+        header.version = PROGRAM_CACHE_VERSION;
+        header.binaryFormat = format;
+        header.keySize = key.size();
+        header.binarySize = written;
+
+        mkdir(directory.c_str(), 0755);
+        std::string target = path(key);
+        std::string temporary = target + ".tmp";
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(key.data(), key.size());
+        out.write(reinterpret_cast<const char *>(binary.data()), written);
+        out.close();
+        if (!out || std::rename(temporary.c_str(), target.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string directory;
+    std::string driver;
+
+    ProgramCache()
+    {
+    }
+
+    // the file name only has to spread keys out, the full key inside is what is checked
+    std::string path(const std::string &key) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) fnv1a64(key.data(), key.size()));
+        return directory + '/' + name;
+    }
+
+    static std::string glString(GLenum name)
+    {
+        const GLubyte *value = glGetString(name);
+        return value ? reinterpret_cast<const char *>(value) : "";
+    }
+};
+#endif
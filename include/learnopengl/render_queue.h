@@ -0,0 +1,347 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/model.h>
+#include <learnopengl/profiler.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// passes are drawn in this order; transparent geometry is sorted back-to-front after everything opaque
+enum RenderPass {
+    PASS_OPAQUE = 0,
+    PASS_TRANSPARENT = 1
+};
+
+// a program registered with the render queue, together with the uniforms the queue sets itself
+struct RenderProgram {
+    Shader *shader;
+    // drawn with instead while the shader is still compiling, -1 to skip those draws
+    int fallback;
+    // the handles below are resolved once the shader is ready
+    bool ready;
+    UniformHandle model;
+    // vertex decoding of the mesh (see VertexLayout)
+    UniformHandle positionScale;
+    UniformHandle positionOffset;
+};
+
+// one draw call: which program draws which mesh with which material, where, and with what extra state
+struct RenderPacket {
+    unsigned int program;
+    const Mesh *mesh;
+    const Material *material;
+    glm::mat4 model;
+    GLsizei instanceCount;  // 0 draws the mesh once with glDrawElements
+    // a buffer of DrawElementsIndirectCommand and the offset of this draw's command, for draws
+    // whose instance count only the GPU knows (see GpuInstanceCuller); 0 for direct draws
+    GLuint indirectBuffer;
+    GLintptr indirectOffset;
+    bool cullFace;
+    int section;  // profiler section the draw is timed under, -1 for none
+};
+
+// collects the draws of a frame, sorts them by a 64-bit key and executes them with as few
+// program, texture and vertex array changes as possible.
+//
+// opaque key:      | pass:4 | program:8 | material:12 | VAO:16 | depth:24 |
+// transparent key: | pass:4 | ~depth:24 | program:8 | material:12 | VAO:16 |
+//
+// programs are ranked in registration order, so registering cheap programs first and the
+// parallax shader last lets the depth buffer reject most of its fragments before they are shaded.
+// inside a program, opaque draws go front-to-back.
+//
+// programs may still be compiling (see Shader::poll); execute() picks up the ones that finished
+// and draws the packets of the others with their fallback program, or not at all.
+class RenderQueue
+{
+public:
+    // registers a program and returns its rank in the sort key (at most 256 programs). fallback is
+    // the rank of an earlier program that can draw the same meshes while this one compiles.
+    // ------------------------------------------------------------------------
+    unsigned int addProgram(Shader &shader, int fallback = -1)
+    {
+        RenderProgram program;
+        program.shader = &shader;
+        program.fallback = fallback;
+        program.ready = false;
+        programs.push_back(program);
+        updateProgram(programs.back(), false);
+        return programs.size() - 1;
+    }
+
+    // how many registered programs are still compiling
+    // ------------------------------------------------------------------------
+    unsigned int pendingPrograms() const
+    {
+        unsigned int count = 0;
+        for (const RenderProgram &program : programs)
+            count += !program.ready;
+        return count;
+    }
+
+    // camera used to compute the depth part of the sort key
+    // ------------------------------------------------------------------------
+    void setCamera(const glm::vec3 &position, float farPlane)
+    {
+        cameraPosition = position;
+        this->farPlane = farPlane;
+    }
+
+    // times the execution of packets under the profiler sections they were submitted with
+    // ------------------------------------------------------------------------
+    void setProfiler(Profiler *profiler)
+    {
+        this->profiler = profiler;
+    }
+
+    // packets submitted from now on are timed under this profiler section (-1 for none)
+    // ------------------------------------------------------------------------
+    void setSection(int section)
+    {
+        currentSection = section;
+    }
+
+    // draws the mesh with its own material
+    // ------------------------------------------------------------------------
+    void submit(unsigned int program, const Mesh &mesh, const glm::mat4 &model, RenderPass pass = PASS_OPAQUE,
+                GLsizei instanceCount = 0, bool cullFace = false)
+    {
+        RenderPacket packet;
+        packet.program = program;
+        packet.mesh = &mesh;
+        packet.material = &mesh.material;
+        packet.model = model;
+        packet.instanceCount = instanceCount;
+        packet.indirectBuffer = 0;
+        packet.indirectOffset = 0;
+        packet.cullFace = cullFace;
+        packet.section = currentSection;
+        push(packet, pass);
+    }
+
+    // draws the mesh instanced, with the parameters at offset in an indirect draw buffer. needs
+    // glExtensions().drawIndirect; the mesh's instance attributes decide where the instances are.
+    // ------------------------------------------------------------------------
+    void submitIndirect(unsigned int program, const Mesh &mesh, GLuint buffer, GLintptr offset,
+                        RenderPass pass = PASS_OPAQUE, bool cullFace = false)
+    {
+        RenderPacket packet;
+        packet.program = program;
+        packet.mesh = &mesh;
+        packet.material = &mesh.material;
+        packet.model = glm::mat4(1.0f);
+        packet.instanceCount = 0;
+        packet.indirectBuffer = buffer;
+        packet.indirectOffset = offset;
+        packet.cullFace = cullFace;
+        packet.section = currentSection;
+        push(packet, pass);
+    }
+
+    // submits every mesh of the model with the same settings
+    // ------------------------------------------------------------------------
+    void submit(unsigned int program, const Model &model, const glm::mat4 &transform, RenderPass pass = PASS_OPAQUE,
+                GLsizei instanceCount = 0, bool cullFace = false)
+    {
+        for (const Mesh &mesh : model.meshes)
+            submit(program, mesh, transform, pass, instanceCount, cullFace);
+    }
+
+    // sorts the submitted packets, draws them and empties the queue
+    // ------------------------------------------------------------------------
+    void execute()
+    {
+        // without parallel compiles finishing a program means waiting for it, so at most one
+        // is waited for per frame
+        bool wait = !glExtensions().parallelShaderCompile;
+        for (RenderProgram &program : programs)
+            if (!program.ready && updateProgram(program, wait))
+                wait = false;
+
+        radixSort(items, scratch);
+
+        // program, culling and VAO changes are filtered by GLState; the material check stays
+        // here because it saves walking the texture slots altogether
+        const Material *material = nullptr;
+        int section = -1;
+        // the mesh whose vertex decoding each program's uniforms currently hold
+        decodedMesh.assign(programs.size(), nullptr);
+        for (const SortItem &item : items)
+        {
+            const RenderPacket &packet = packets[item.index];
+            unsigned int rank = packet.program;
+            if (!programs[rank].ready)
+            {
+                int fallback = programs[rank].fallback;
+                if (fallback < 0 || !programs[fallback].ready)
+                    continue;
+                rank = fallback;
+            }
+            // sorting can split a section into several runs; the profiler sums them
+            if (profiler && section != packet.section)
+            {
+                profiler->end(section);
+                section = packet.section;
+                profiler->begin(section);
+            }
+            const RenderProgram *program = &programs[rank];
+            program->shader->use();
+            // the samplers of every program use the same fixed units, so switching programs
+            // keeps the bound material valid
+            if (material != packet.material)
+            {
+                material = packet.material;
+                material->bind();
+            }
+            GLState::setEnabled(GL_CULL_FACE, packet.cullFace);
+            if (packet.cullFace)
+            {
+                GLState::cullFace(GL_BACK);
+                GLState::frontFace(GL_CW);
+            }
+            GLState::bindVertexArray(packet.mesh->VAO);
+            if (decodedMesh[rank] != packet.mesh)
+            {
+                const Mesh *mesh = packet.mesh;
+                decodedMesh[rank] = mesh;
+                program->shader->setVec3(program->positionScale, mesh->positionScale);
+                program->shader->setVec3(program->positionOffset, mesh->positionOffset);
+            }
+
+            GLsizei count = packet.mesh->indexCount;
+            GLenum indexType = packet.mesh->indexType;
+            if (packet.indirectBuffer != 0)
+            {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, packet.indirectBuffer);
+                glExtensions().drawElementsIndirectProc(GL_TRIANGLES, indexType,
+                                                        reinterpret_cast<const void *>(packet.indirectOffset));
+            }
+            else if (packet.instanceCount > 0)
+                glDrawElementsInstanced(GL_TRIANGLES, count, indexType, nullptr, packet.instanceCount);
+            else
+            {
+                program->shader->setMat4(program->model, packet.model);
+                glDrawElements(GL_TRIANGLES, count, indexType, nullptr);
+            }
+        }
+
+        // always good practice to set everything back to defaults once the queue is done.
+        if (profiler)
+            profiler->end(section);
+
+        GLState::disable(GL_CULL_FACE);
+        GLState::activeTexture(0);
+        if (glExtensions().drawIndirect)
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        clear();
+    }
+
+    // ------------------------------------------------------------------------
+    void clear()
+    {
+        packets.clear();
+        items.clear();
+    }
+
+private:
+    struct SortItem {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<RenderProgram> programs;
+    std::vector<RenderPacket> packets;
+    std::vector<SortItem> items;
+    std::vector<SortItem> scratch;
+    std::vector<const Mesh *> decodedMesh;
+    Profiler *profiler = nullptr;
+    int currentSection = -1;
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float farPlane = 100.0f;
+
+    // polls a program that isn't ready and resolves its handles once it is; true if it became ready
+    // ------------------------------------------------------------------------
+    static bool updateProgram(RenderProgram &program, bool wait)
+    {
+        if (!program.shader->poll(wait))
+            return false;
+        program.ready = true;
+        program.model = program.shader->handle("model");
+        program.positionScale = program.shader->vertexDecode().positionScale;
+        program.positionOffset = program.shader->vertexDecode().positionOffset;
+        return true;
+    }
+
+    // ------------------------------------------------------------------------
+    void push(const RenderPacket &packet, RenderPass pass)
+    {
+        SortItem item;
+        item.key = makeKey(packet, pass);
+        item.index = packets.size();
+        packets.push_back(packet);
+        items.push_back(item);
+    }
+
+    // ------------------------------------------------------------------------
+    uint64_t makeKey(const RenderPacket &packet, RenderPass pass) const
+    {
+        uint64_t material = packet.material->id & 0xFFF;
+        uint64_t vao = packet.mesh->VAO & 0xFFFF;
+        uint64_t program = packet.program & 0xFF;
+
+        float distance = glm::length(glm::vec3(packet.model[3]) - cameraPosition) / farPlane;
+        distance = std::min(std::max(distance, 0.0f), 1.0f);
+        uint64_t depth = (uint64_t) (distance * 0xFFFFFF);
+
+        uint64_t key = (uint64_t) pass << 60;
+        if (pass == PASS_TRANSPARENT)
+            key |= ((0xFFFFFF - depth) << 36) | (program << 28) | (material << 16) | vao;
+        else
+            key |= (program << 52) | (material << 40) | (vao << 24) | depth;
+        return key;
+    }
+
+    // least significant digit radix sort on the 64-bit keys, one byte per pass.
+    // passes where every key has the same byte are skipped, which is the common case for the upper bytes.
+    // ------------------------------------------------------------------------
+    static void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &scratch)
+    {
+        size_t n = items.size();
+        if (n < 2)
+            return;
+        scratch.resize(n);
+        SortItem *src = items.data();
+        SortItem *dst = scratch.data();
+        for (unsigned int shift = 0; shift < 64; shift += 8)
+        {
+            size_t counts[256] = {};
+            for (size_t i = 0; i < n; i++)
+                counts[(src[i].key >> shift) & 0xFF]++;
+            if (counts[(src[0].key >> shift) & 0xFF] == n)
+                continue;
+            size_t offset = 0;
+            for (unsigned int b = 0; b < 256; b++)
+            {
+                size_t count = counts[b];
+                counts[b] = offset;
+                offset += count;
+            }
+            for (size_t i = 0; i < n; i++)
+                dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+            std::swap(src, dst);
+        }
+        if (src != items.data())
+            items.swap(scratch);
+    }
+};
+#endif
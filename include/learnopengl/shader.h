@@ -4,174 +4,586 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 #include <common.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/material.h>
+#include <learnopengl/program_cache.h>
+#include <learnopengl/startup_trace.h>
+
+// location of an active uniform, resolved once when the program is linked.
+// an invalid handle (-1) is silently ignored by glUniform*, same as an unknown name.
+struct UniformHandle
+{
+    GLint location = -1;
+
+    bool valid() const { return location != -1; }
+};
+
+// the uniforms the vertex shaders use to decode the packed vertex layout (see VertexLayout in
+// mesh.h), resolved with the rest at link time so drawing a mesh needs no name lookups
+struct VertexDecodeHandles
+{
+    UniformHandle positionScale;
+    UniformHandle positionOffset;
+};
+
+// one stage's source after preprocessing, and the files it was put together from. in compiler
+// messages, source string n is files[n].
+struct ShaderSource
+{
+    std::string code;
+    std::vector<std::string> files;
+    uint64_t bytesRead = 0;
+};
+
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly. defines are #define lines put at the top of
+    // every stage, after #version; each set of defines is a program of its own. an async shader
+    // only starts compiling here and can't be used before ready() (see poll()).
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+           const std::string &defines = std::string(), bool async = false)
     {
-        std::string vertexPathString(vertexPath);
-        std::string fragmentPathString(fragmentPath);
-
-        vertexPath = vertexPathString.c_str();
-        fragmentPath= fragmentPathString.c_str();
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                std::string geometryPathString(geometryPath);
-                geometryPath = geometryPathString.c_str();
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (std::ifstream::failure& e)
-        {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-        }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
+        build(vertexPath, fragmentPath, geometryPath, defines, async);
+    }
+    // a program that only runs the vertex and geometry stages, for passes drawn with
+    // GL_RASTERIZER_DISCARD: the named outputs of the last stage are captured, interleaved in
+    // the order given, into the buffer bound to GL_TRANSFORM_FEEDBACK_BUFFER index 0.
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* geometryPath, const std::vector<std::string> &feedbackVaryings,
+           const std::string &defines = std::string())
+        : feedbackVaryings(feedbackVaryings)
+    {
+        build(vertexPath, nullptr, geometryPath, defines, false);
+    }
+    // whether the program is linked and can be used
+    // ------------------------------------------------------------------------
+    bool ready() const
+    {
+        return !pending;
+    }
+    // finishes an async build if the driver is done with it, or with wait, once it is. without
+    // GL_KHR_parallel_shader_compile there is no way to ask, so only waiting finishes it.
+    // ------------------------------------------------------------------------
+    bool poll(bool wait = false)
+    {
+        if (!pending)
+            return true;
+        if (!wait)
         {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            if (!glExtensions().parallelShaderCompile)
+                return false;
+            GLint complete = GL_FALSE;
+            glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+            if (!complete)
+                return false;
         }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+        finishBuild();
+        return true;
+    }
+    // runs callback once the program is ready, right away if it already is. uniforms and block
+    // bindings set before that would be lost, so one-time setup of async programs goes here.
+    // ------------------------------------------------------------------------
+    void whenReady(const std::function<void(Shader &)> &callback)
+    {
+        if (ready())
+            callback(*this);
+        else
+            readyCallbacks.push_back(callback);
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        GLState::useProgram(ID); 
+    }
+    // points a uniform block of this program at a fixed binding point, where a UniformBuffer is attached.
+    // programs that don't declare the block are left alone.
+    // ------------------------------------------------------------------------
+    void bindUniformBlock(const std::string &blockName, GLuint bindingPoint) const
+    {
+        GLuint index = glGetUniformBlockIndex(ID, blockName.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, bindingPoint);
+    }
+    // looks up a uniform in the table built at link time. resolve handles once
+    // outside of the render loop and pass them to the setters below.
+    // ------------------------------------------------------------------------
+    UniformHandle handle(const std::string &name) const
+    {
+        UniformHandle handle;
+        auto it = uniformLocations.find(name);
+        if (it != uniformLocations.end())
+            handle.location = it->second;
+        return handle;
+    }
+    // ------------------------------------------------------------------------
+    const VertexDecodeHandles &vertexDecode() const
+    {
+        return decodeHandles;
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        setBool(handle(name), value);
+    }
+    void setBool(UniformHandle handle, bool value) const
+    {
+        glUniform1i(handle.location, (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        setInt(handle(name), value);
+    }
+    void setInt(UniformHandle handle, int value) const
+    {
+        glUniform1i(handle.location, value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        setFloat(handle(name), value);
+    }
+    void setFloat(UniformHandle handle, float value) const
+    {
+        glUniform1f(handle.location, value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec2(handle(name), value);
+    }
+    void setVec2(UniformHandle handle, const glm::vec2 &value) const
+    {
+        glUniform2fv(handle.location, 1, &value[0]);
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        setVec2(handle(name), x, y);
+    }
+    void setVec2(UniformHandle handle, float x, float y) const
+    {
+        glUniform2f(handle.location, x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec3(handle(name), value);
+    }
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const
+    {
+        glUniform3fv(handle.location, 1, &value[0]);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        setVec3(handle(name), x, y, z);
+    }
+    void setVec3(UniformHandle handle, float x, float y, float z) const
+    {
+        glUniform3f(handle.location, x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec4(handle(name), value);
+    }
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const
+    {
+        glUniform4fv(handle.location, 1, &value[0]);
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        setVec4(handle(name), x, y, z, w);
+    }
+    void setVec4(UniformHandle handle, float x, float y, float z, float w)
+    {
+        glUniform4f(handle.location, x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(handle(name), mat);
+    }
+    void setMat2(UniformHandle handle, const glm::mat2 &mat) const
+    {
+        glUniformMatrix2fv(handle.location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(handle(name), mat);
+    }
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(handle(name), mat);
+    }
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // a build that was started and not looked at since; stages that aren't used are 0
+    struct PendingBuild
+    {
+        GLuint stages[3] = {};
+        std::vector<std::string> files[3];
+        std::string cacheKey;
+        std::string traceName;
+        StartupTrace::Clock::time_point traceStart;
+        uint64_t bytesRead = 0;
+    };
+
+    // name -> location of every active uniform of the linked program
+    std::unordered_map<std::string, GLint> uniformLocations;
+    VertexDecodeHandles decodeHandles;
+    std::unique_ptr<PendingBuild> pending;
+    std::vector<std::function<void(Shader &)>> readyCallbacks;
+    std::vector<std::string> feedbackVaryings;
+
+    // loads, preprocesses and links the stages; fragmentPath and geometryPath may be null
+    // ------------------------------------------------------------------------
+    void build(const char* vertexPath, const char* fragmentPath, const char* geometryPath, const std::string &defines,
+               bool async)
+    {
+        std::string vertexPathString(vertexPath);
+        std::string lastPathString(fragmentPath != nullptr ? fragmentPath : geometryPath != nullptr ? geometryPath : "");
+        std::string traceName = vertexPathString + " + " + lastPathString.substr(lastPathString.find_last_of('/') + 1);
+        if (!defines.empty())
+            traceName += " [" + defineNames(defines) + "]";
+        StartupTrace::Clock::time_point traceStart = StartupTrace::Clock::now();
+
+        // 1. retrieve the vertex/fragment source code from filePath, through the asset pack if one is mounted,
+        //    and expand its includes and defines
+        ShaderSource vertexSource;
+        ShaderSource fragmentSource;
+        ShaderSource geometrySource;
+        bool read = preprocess(vertexPath, defines, vertexSource);
+        if (fragmentPath != nullptr)
+            read = preprocess(fragmentPath, defines, fragmentSource) && read;
+        // if geometry shader path is present, also load a geometry shader
+        if (geometryPath != nullptr)
+            read = preprocess(geometryPath, defines, geometrySource) && read;
+        if (!read)
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        uint64_t bytesRead = vertexSource.bytesRead + fragmentSource.bytesRead + geometrySource.bytesRead;
+        // 2. take the binary saved by an earlier run if the driver still accepts it. captured
+        //    outputs are part of the link, so they are part of the key
+        ProgramCache &cache = ProgramCache::instance();
+        std::string cacheKey = cache.key(sourceHash(vertexSource.code, fragmentSource.code, geometrySource.code), defines);
+        for (const std::string &varying : feedbackVaryings)
+            cacheKey += " feedback=" + varying;
+        ID = glCreateProgram();
+        if (cache.load(ID, cacheKey, bytesRead))
+        {
+            reflectUniforms();
+            StartupTrace::instance().record("shader cache", traceName, traceStart, bytesRead);
+            return;
+        }
+        // 3. otherwise compile and link from source, and save the result for next time. the driver
+        //    may work on it in the background, it is only waited for when it is finished below
+        glDeleteProgram(ID);
+        pending.reset(new PendingBuild());
+        pending->cacheKey = cacheKey;
+        pending->traceName = traceName;
+        pending->traceStart = traceStart;
+        pending->bytesRead = bytesRead;
+        startBuild(vertexSource, fragmentPath != nullptr ? &fragmentSource : nullptr,
+                   geometryPath != nullptr ? &geometrySource : nullptr);
+        if (async)
+            StartupTrace::instance().record("shader submit", traceName, traceStart, bytesRead);
+        else
+            finishBuild();
+    }
+
+    // reads a whole source file; false if it doesn't exist
+    // ------------------------------------------------------------------------
+    static bool readSource(const char *path, std::string &source)
+    {
+        MappedFile file(path);
+        if (!file.valid())
+            return false;
+        source.assign(reinterpret_cast<const char *>(file.data()), file.size());
+        return true;
+    }
+
+    // reads a stage and expands it: defines go right after the #version line, and each
+    // #include "file" (relative to the including file) is replaced by that file, the first time
+    // it is included in the stage; later includes of the same file are dropped. #line directives
+    // keep compiler messages pointing at the original files and lines.
+    // ------------------------------------------------------------------------
+    static bool preprocess(const char *path, const std::string &defines, ShaderSource &source)
+    {
+        source = ShaderSource();
+        return expand(path, &defines, source);
+    }
+
+    static bool expand(const std::string &path, const std::string *defines, ShaderSource &source)
+    {
+        std::string text;
+        if (!readSource(path.c_str(), text))
+            return false;
+        source.bytesRead += text.size();
+        std::string fileNumber = std::to_string(source.files.size());
+        source.files.push_back(path);
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+
+        size_t start = 0;
+        unsigned int lineNumber = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos)
+                end = text.size();
+            std::string line = text.substr(start, end - start);
+            start = end + 1;
+            lineNumber++;
+            // where the compiler has to pick up again after anything inserted in place of this line
+            std::string resume = "#line " + std::to_string(lineNumber + 1) + " " + fileNumber + "\n";
+            std::string included;
+            if (defines && !defines->empty() && isDirective(line, "#version"))
+                source.code += line + "\n" + *defines + resume;
+            else if (isDirective(line, "#include") && includedPath(line, included))
+            {
+                std::string target = directory + included;
+                if (std::find(source.files.begin(), source.files.end(), target) != source.files.end())
+                {
+                    source.code += "\n";
+                    continue;
+                }
+                source.code += "#line 1 " + std::to_string(source.files.size()) + "\n";
+                if (!expand(target, nullptr, source))
+                {
+                    std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << target << " in " << path << std::endl;
+                    return false;
+                }
+                source.code += resume;
+            }
+            else
+                source.code += line + "\n";
+        }
+        return true;
+    }
+
+    static bool isDirective(const std::string &line, const char *directive)
+    {
+        size_t first = line.find_first_not_of(" \t");
+        return first != std::string::npos && line.compare(first, std::strlen(directive), directive) == 0;
+    }
+
+    // the file name between the quotes of an #include
+    static bool includedPath(const std::string &line, std::string &path)
+    {
+        size_t open = line.find('"');
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos)
+            return false;
+        path = line.substr(open + 1, close - open - 1);
+        return !path.empty();
+    }
+
+    // "#define NORMAL_MAP\n#define SPOT_LIGHTS 3\n" as "NORMAL_MAP SPOT_LIGHTS=3", to tell programs apart
+    static std::string defineNames(const std::string &defines)
+    {
+        std::istringstream lines(defines);
+        std::string line, names;
+        while (std::getline(lines, line))
+        {
+            std::istringstream words(line);
+            std::string directive, name, value;
+            if (!(words >> directive >> name) || directive != "#define")
+                continue;
+            names += (names.empty() ? "" : " ") + name;
+            if (words >> value)
+                names += "=" + value;
+        }
+        return names;
+    }
+
+    // one hash over every stage, each prefixed with its length so stages can't run into each other
+    // ------------------------------------------------------------------------
+    static uint64_t sourceHash(const std::string &vertexCode, const std::string &fragmentCode,
+                               const std::string &geometryCode)
+    {
+        uint64_t hash = fnv1a64(nullptr, 0);
+        for (const std::string *code : {&vertexCode, &fragmentCode, &geometryCode})
+        {
+            uint64_t size = code->size();
+            hash = fnv1a64(&size, sizeof(size), hash);
+            hash = fnv1a64(code->data(), code->size(), hash);
+        }
+        return hash;
+    }
+
+    // compiles the stages and links them into a new program, without asking for the results, so a
+    // driver with parallel compiles isn't made to wait for them
+    // ------------------------------------------------------------------------
+    void startBuild(const ShaderSource &vertexSource, const ShaderSource *fragmentSource, const ShaderSource *geometrySource)
+    {
+        const char* vShaderCode = vertexSource.code.c_str();
+        unsigned int vertex;
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        // fragment Shader, unless nothing is rasterized
+        unsigned int fragment = 0;
+        if(fragmentSource != nullptr)
+        {
+            const char * fShaderCode = fragmentSource->code.c_str();
+            fragment = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(fragment, 1, &fShaderCode, NULL);
+            glCompileShader(fragment);
+        }
+        // if geometry shader is given, compile geometry shader
+        unsigned int geometry = 0;
+        if(geometrySource != nullptr)
+        {
+            const char * gShaderCode = geometrySource->code.c_str();
+            geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            glCompileShader(geometry);
+        }
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        if(fragmentSource != nullptr)
+            glAttachShader(ID, fragment);
+        if(geometrySource != nullptr)
+            glAttachShader(ID, geometry);
+        if (!feedbackVaryings.empty())
+        {
+            std::vector<const char *> names;
+            for (const std::string &varying : feedbackVaryings)
+                names.push_back(varying.c_str());
+            glTransformFeedbackVaryings(ID, (GLsizei) names.size(), names.data(), GL_INTERLEAVED_ATTRIBS);
+        }
+        ProgramCache::instance().prepare(ID);
+        glLinkProgram(ID);
+
+        pending->stages[0] = vertex;
+        pending->stages[1] = fragment;
+        pending->stages[2] = geometry;
+        pending->files[0] = vertexSource.files;
+        if (fragmentSource != nullptr)
+            pending->files[1] = fragmentSource->files;
+        if (geometrySource != nullptr)
+            pending->files[2] = geometrySource->files;
+    }
+
+    // reports the errors of the started build, saves the binary and makes the program usable
+    // ------------------------------------------------------------------------
+    void finishBuild()
+    {
+        std::unique_ptr<PendingBuild> build = std::move(pending);
+        const char *types[3] = {"VERTEX", "FRAGMENT", "GEOMETRY"};
+        for (int i = 0; i < 3; i++)
+        {
+            if (!build->stages[i])
+                continue;
+            checkCompileErrors(build->stages[i], types[i], &build->files[i]);
+            // delete the shaders as they're linked into our program now and no longer necessery
+            glDeleteShader(build->stages[i]);
+        }
+        checkCompileErrors(ID, "PROGRAM");
+        GLint linked = GL_FALSE;
+        glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+        if (linked)
+            ProgramCache::instance().save(ID, build->cacheKey);
+
+        reflectUniforms();
+        // for an async build this runs from submission until the build was noticed to be done
+        StartupTrace::instance().record("shader compile", build->traceName, build->traceStart, build->bytesRead);
+        std::vector<std::function<void(Shader &)>> callbacks;
+        callbacks.swap(readyCallbacks);
+        for (const auto &callback : callbacks)
+            callback(*this);
+    }
+
+    // queries all active uniforms once after linking, so setters never have to ask the driver.
+    // arrays of basic types are reported only as "name[0]", so every element and the bare
+    // array name are registered as well. material samplers are pointed at their fixed
+    // texture units here, so drawing never has to set them.
+    // ------------------------------------------------------------------------
+    void reflectUniforms()
+    {
+        std::vector<std::pair<GLint, TextureSlot>> samplers;
+        GLint count = 0;
+        GLint maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> nameBuffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+            std::string name(nameBuffer.data(), length);
+            GLint location = glGetUniformLocation(ID, name.c_str());
+            // members of uniform blocks have no location
+            if (location == -1)
+                continue;
+            uniformLocations[name] = location;
+            if (type == GL_SAMPLER_2D)
+            {
+                TextureSlot slot = textureSlotFromSampler(name);
+                if (slot != TEXTURE_SLOT_NONE)
+                    samplers.push_back(std::make_pair(location, slot));
+            }
+
+            std::string::size_type bracket = name.size() >= 3 ? name.size() - 3 : std::string::npos;
+            if (bracket != std::string::npos && name.compare(bracket, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, bracket);
+                uniformLocations[base] = location;
+                for (GLint j = 1; j < size; j++)
+                {
+                    std::string element = base + "[" + std::to_string(j) + "]";
+                    uniformLocations[element] = glGetUniformLocation(ID, element.c_str());
+                }
+            }
+        }
+        decodeHandles.positionScale = handle("positionScale");
+        decodeHandles.positionOffset = handle("positionOffset");
+
+        if (!samplers.empty())
+        {
+            GLint previous = 0;
+            glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+            glUseProgram(ID);
+            for (const auto &sampler : samplers)
+                glUniform1i(sampler.first, sampler.second);
+            glUseProgram(previous);
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    void checkCompileErrors(GLuint shader, std::string type, const std::vector<std::string> *files = nullptr)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -181,7 +593,11 @@ private:
             if(!success)
             {
                 glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n";
+                // messages name files by their source string number
+                for (size_t i = 0; files && files->size() > 1 && i < files->size(); i++)
+                    std::cout << i << ": " << (*files)[i] << "\n";
+                std::cout << " -- --------------------------------------------------- -- " << std::endl;
             }
         }
         else
@@ -0,0 +1,91 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <learnopengl/lights.h>
+#include <learnopengl/material.h>
+#include <learnopengl/shader.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+// the compile-time features of the lit shaders (lit.fs and the vertex shaders feeding it). every
+// combination is a program of its own, with the branches resolved by the preprocessor instead of
+// uniforms tested per fragment.
+struct ShaderVariant {
+    bool normalMap = false;     // lighting in tangent space, with the normal from the normal map
+    bool parallax = false;      // offsets texture coordinates along the height map; implies normalMap
+    unsigned int pointLights = 1;
+    unsigned int spotLights = NR_SPOT_LIGHTS;
+
+    // what a material's textures call for
+    static ShaderVariant forMaterial(const Material &material)
+    {
+        ShaderVariant variant;
+        variant.normalMap = material.textures[TEXTURE_NORMAL] != 0;
+        variant.parallax = variant.normalMap && material.textures[TEXTURE_HEIGHT] != 0;
+        return variant;
+    }
+
+    // variants with the same key compile to the same program
+    uint32_t key() const
+    {
+        return (uint32_t) (normalMap || parallax) | (uint32_t) parallax << 1 | std::min(pointLights, 1u) << 2 |
+               std::min(spotLights, NR_SPOT_LIGHTS) << 3;
+    }
+
+    // the #define lines handed to Shader
+    std::string defines() const
+    {
+        std::string text;
+        if (normalMap || parallax)
+            text += "#define NORMAL_MAP\n";
+        if (parallax)
+            text += "#define PARALLAX_MAPPING\n";
+        text += "#define POINT_LIGHTS " + std::to_string(std::min(pointLights, 1u)) + "\n";
+        text += "#define SPOT_LIGHTS " + std::to_string(std::min(spotLights, NR_SPOT_LIGHTS)) + "\n";
+        return text;
+    }
+};
+
+// the variants of one vertex/fragment pair, each compiled (or taken from the ProgramCache) the
+// first time it is asked for, asynchronously if async is set then. programs live as long as this
+// object and never move, so the references handed out can be registered with the render queue.
+class ShaderVariants
+{
+public:
+    ShaderVariants(const std::string &vertexPath, const std::string &fragmentPath)
+        : vertexPath(vertexPath), fragmentPath(fragmentPath)
+    {
+    }
+
+    ShaderVariants(const ShaderVariants &) = delete;
+    ShaderVariants &operator=(const ShaderVariants &) = delete;
+
+    // ------------------------------------------------------------------------
+    Shader &get(const ShaderVariant &variant, bool async = false)
+    {
+        uint32_t key = variant.key();
+        auto it = programs.find(key);
+        if (it == programs.end())
+        {
+            std::unique_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, variant.defines(), async));
+            it = programs.emplace(key, std::move(shader)).first;
+        }
+        return *it->second;
+    }
+
+    // how many variants have been compiled so far
+    size_t size() const
+    {
+        return programs.size();
+    }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::map<uint32_t, std::unique_ptr<Shader>> programs;
+};
+#endif
@@ -0,0 +1,210 @@
+#ifndef STARTUP_TRACE_H
+#define STARTUP_TRACE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// where launch time goes, up to the first presented frame: the phases of main, and per model,
+// texture and shader the wall time, the bytes read from disk and the bytes uploaded to the GPU.
+// the loader threads record as well, so recording is locked; once finish() is called the trace
+// is frozen and later records are dropped, so the same code paths cost nothing while running.
+struct StartupEvent {
+    std::string category;   // phase, model parse, model upload, texture load, texture upload,
+                            // shader compile or shader cache
+    std::string name;
+    bool worker;            // recorded off the thread that created the trace
+    double startMs;         // since the trace began
+    double durationMs;
+    uint64_t bytesRead;
+    uint64_t bytesUploaded;
+};
+
+class StartupTrace
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // the first call starts the trace, so main makes it before anything else
+    static StartupTrace &instance()
+    {
+        static StartupTrace trace;
+        return trace;
+    }
+
+    // adds an event that started at start and ends now
+    // ------------------------------------------------------------------------
+    void record(const std::string &category, const std::string &name, Clock::time_point start,
+                uint64_t bytesRead = 0, uint64_t bytesUploaded = 0)
+    {
+        Clock::time_point end = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished)
+            return;
+        StartupEvent event;
+        event.category = category;
+        event.name = name;
+        event.worker = std::this_thread::get_id() != mainThread;
+        event.startMs = milliseconds(origin, start);
+        event.durationMs = milliseconds(start, end);
+        event.bytesRead = bytesRead;
+        event.bytesUploaded = bytesUploaded;
+        events.push_back(event);
+    }
+
+    // freezes the trace; call once the first frame has been presented
+    // ------------------------------------------------------------------------
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!finished)
+            totalMs = milliseconds(origin, Clock::now());
+        finished = true;
+    }
+
+    bool done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return finished;
+    }
+
+    // one line per event in start order, then the sums per category. worker events overlap each
+    // other and the main thread, so only the phases add up to the total.
+    // ------------------------------------------------------------------------
+    void print()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<StartupEvent> sorted = sortedEvents();
+        printf("startup: %.1f ms to the first presented frame\n", totalMs);
+        printf("%-15s %-40s %-6s %9s %9s %10s %10s\n", "category", "name", "thread", "start ms", "ms", "read KiB",
+               "upload KiB");
+        for (const StartupEvent &event : sorted)
+            printf("%-15s %-40s %-6s %9.1f %9.2f %10.1f %10.1f\n", event.category.c_str(), shorten(event.name).c_str(),
+                   event.worker ? "worker" : "main", event.startMs, event.durationMs, event.bytesRead / 1024.0,
+                   event.bytesUploaded / 1024.0);
+
+        std::vector<std::string> categories;
+        for (const StartupEvent &event : sorted)
+            if (std::find(categories.begin(), categories.end(), event.category) == categories.end())
+                categories.push_back(event.category);
+        for (const std::string &category : categories)
+        {
+            double ms = 0.0;
+            uint64_t read = 0, uploaded = 0;
+            unsigned int count = 0;
+            for (const StartupEvent &event : sorted)
+                if (event.category == category)
+                {
+                    ms += event.durationMs;
+                    read += event.bytesRead;
+                    uploaded += event.bytesUploaded;
+                    count++;
+                }
+            printf("%-15s %-40s %-6s %9s %9.2f %10.1f %10.1f\n", category.c_str(), ("total of " + std::to_string(count)).c_str(),
+                   "", "", ms, read / 1024.0, uploaded / 1024.0);
+        }
+    }
+
+    // the same events as JSON, for scripts comparing cold and warm starts
+    // ------------------------------------------------------------------------
+    bool writeJson(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        std::vector<StartupEvent> sorted = sortedEvents();
+        fprintf(file, "{\n  \"totalMs\": %.3f,\n  \"events\": [", totalMs);
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const StartupEvent &event = sorted[i];
+            fprintf(file,
+                    "%s\n    {\"category\": \"%s\", \"name\": \"%s\", \"thread\": \"%s\", \"startMs\": %.3f, "
+                    "\"durationMs\": %.3f, \"bytesRead\": %llu, \"bytesUploaded\": %llu}",
+                    i ? "," : "", escape(event.category).c_str(), escape(event.name).c_str(),
+                    event.worker ? "worker" : "main", event.startMs, event.durationMs,
+                    (unsigned long long) event.bytesRead, (unsigned long long) event.bytesUploaded);
+        }
+        fprintf(file, "\n  ]\n}\n");
+        return fclose(file) == 0;
+    }
+
+private:
+    std::mutex mutex;
+    Clock::time_point origin = Clock::now();
+    std::thread::id mainThread = std::this_thread::get_id();
+    std::vector<StartupEvent> events;
+    bool finished = false;
+    double totalMs = 0.0;
+
+    StartupTrace()
+    {
+    }
+
+    static double milliseconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    std::vector<StartupEvent> sortedEvents() const
+    {
+        std::vector<StartupEvent> sorted = events;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const StartupEvent &a, const StartupEvent &b) {
+            return a.startMs < b.startMs;
+        });
+        return sorted;
+    }
+
+    // keeps the end of long paths, which is the part that tells them apart
+    static std::string shorten(const std::string &name)
+    {
+        return name.size() <= 40 ? name : "..." + name.substr(name.size() - 37);
+    }
+
+    static std::string escape(const std::string &text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            if ((unsigned char) c < 0x20)
+                continue;
+            escaped += c;
+        }
+        return escaped;
+    }
+};
+
+// records the time from construction to destruction; bytes can be filled in on the way
+class StartupScope
+{
+public:
+    uint64_t bytesRead = 0;
+    uint64_t bytesUploaded = 0;
+
+    StartupScope(const std::string &category, const std::string &name)
+        : category(category), name(name), start(StartupTrace::Clock::now())
+    {
+    }
+
+    ~StartupScope()
+    {
+        StartupTrace::instance().record(category, name, start, bytesRead, bytesUploaded);
+    }
+
+    StartupScope(const StartupScope &) = delete;
+    StartupScope &operator=(const StartupScope &) = delete;
+
+private:
+    std::string category;
+    std::string name;
+    StartupTrace::Clock::time_point start;
+};
+#endif
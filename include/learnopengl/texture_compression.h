@@ -0,0 +1,254 @@
+#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// S3TC is an extension (EXT_texture_compression_s3tc) and not part of the glad core profile
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// block compressed formats the texture cooker produces. all of them encode 4x4 pixel blocks.
+//   BC1 (DXT1):  RGB color, 8 bytes per block
+//   BC3 (DXT5):  RGBA color, BC4 alpha followed by BC1 color, 16 bytes per block
+//   BC4 (RGTC1): one channel, used for height maps, 8 bytes per block
+//   BC5 (RGTC2): two channels, used for tangent space normals (z is rebuilt in the shader), 16 bytes per block
+enum CompressedFormat {
+    FORMAT_BC1 = 0,
+    FORMAT_BC3,
+    FORMAT_BC4,
+    FORMAT_BC5
+};
+
+inline unsigned int compressedBlockBytes(CompressedFormat format)
+{
+    return format == FORMAT_BC1 || format == FORMAT_BC4 ? 8 : 16;
+}
+
+inline GLenum compressedInternalFormat(CompressedFormat format)
+{
+    switch (format)
+    {
+        case FORMAT_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case FORMAT_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case FORMAT_BC4: return GL_COMPRESSED_RED_RGTC1;
+        case FORMAT_BC5: return GL_COMPRESSED_RG_RGTC2;
+    }
+    return 0;
+}
+
+inline GLenum compressedBaseFormat(CompressedFormat format)
+{
+    switch (format)
+    {
+        case FORMAT_BC1: return GL_RGB;
+        case FORMAT_BC3: return GL_RGBA;
+        case FORMAT_BC4: return GL_RED;
+        case FORMAT_BC5: return GL_RG;
+    }
+    return 0;
+}
+
+inline size_t compressedLevelBytes(CompressedFormat format, int width, int height)
+{
+    return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * compressedBlockBytes(format);
+}
+
+// ------------------------------------------------------------------------
+// block encoders. the input is always a 4x4 block of RGBA8 pixels, row by row.
+
+inline uint16_t packRGB565(const float color[3])
+{
+    int r = std::min(31, std::max(0, (int) std::lround(color[0] * 31.0f / 255.0f)));
+    int g = std::min(63, std::max(0, (int) std::lround(color[1] * 63.0f / 255.0f)));
+    int b = std::min(31, std::max(0, (int) std::lround(color[2] * 31.0f / 255.0f)));
+    return (uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRGB565(uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// endpoints are the extremes of the block along its principal axis, found by power iteration
+// on the color covariance; every pixel then takes the nearest of the four palette colors.
+inline void encodeBC1Block(const unsigned char *rgba, unsigned char *out)
+{
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            mean[c] += rgba[i * 4 + c] / 16.0f;
+
+    float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+    {
+        float r = rgba[i * 4 + 0] - mean[0];
+        float g = rgba[i * 4 + 1] - mean[1];
+        float b = rgba[i * 4 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    int minIndex = 0, maxIndex = 0;
+    float minDot = 1e30f, maxDot = -1e30f;
+    for (int i = 0; i < 16; i++)
+    {
+        float dot = rgba[i * 4 + 0] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+        if (dot < minDot) { minDot = dot; minIndex = i; }
+        if (dot > maxDot) { maxDot = dot; maxIndex = i; }
+    }
+    float high[3], low[3];
+    for (int c = 0; c < 3; c++)
+    {
+        high[c] = rgba[maxIndex * 4 + c];
+        low[c] = rgba[minIndex * 4 + c];
+    }
+    uint16_t c0 = packRGB565(high);
+    uint16_t c1 = packRGB565(low);
+    // c0 > c1 selects the four color mode
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    int palette[4][3];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 4; p++)
+            {
+                int dr = rgba[i * 4 + 0] - palette[p][0];
+                int dg = rgba[i * 4 + 1] - palette[p][1];
+                int db = rgba[i * 4 + 2] - palette[p][2];
+                int error = dr * dr + dg * dg + db * db;
+                if (error < bestError) { bestError = error; best = p; }
+            }
+            indices |= (uint32_t) best << (2 * i);
+        }
+    }
+
+    out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// one channel of the block, picked with stride 4 from the RGBA pixels starting at offset channel
+inline void encodeBC4Block(const unsigned char *rgba, int channel, unsigned char *out)
+{
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        low = std::min(low, (int) rgba[i * 4 + channel]);
+        high = std::max(high, (int) rgba[i * 4 + channel]);
+    }
+    // a0 > a1 selects the mode with six interpolated values between the endpoints
+    int palette[8];
+    palette[0] = high;
+    palette[1] = low;
+    for (int i = 1; i < 7; i++)
+        palette[i + 1] = ((7 - i) * high + i * low) / 7;
+
+    uint64_t indices = 0;
+    if (high != low)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            int value = rgba[i * 4 + channel];
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 8; p++)
+            {
+                int error = std::abs(value - palette[p]);
+                if (error < bestError) { bestError = error; best = p; }
+            }
+            indices |= (uint64_t) best << (3 * i);
+        }
+    }
+
+    out[0] = (unsigned char) high;
+    out[1] = (unsigned char) low;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+inline void encodeBlock(CompressedFormat format, const unsigned char *rgba, unsigned char *out)
+{
+    switch (format)
+    {
+        case FORMAT_BC1:
+            encodeBC1Block(rgba, out);
+            break;
+        case FORMAT_BC3:
+            encodeBC4Block(rgba, 3, out);
+            encodeBC1Block(rgba, out + 8);
+            break;
+        case FORMAT_BC4:
+            encodeBC4Block(rgba, 0, out);
+            break;
+        case FORMAT_BC5:
+            encodeBC4Block(rgba, 0, out);
+            encodeBC4Block(rgba, 1, out + 8);
+            break;
+    }
+}
+
+// compresses one RGBA8 image; blocks reaching past the edge repeat the last row and column
+// ------------------------------------------------------------------------
+inline void compressImage(CompressedFormat format, const unsigned char *rgba, int width, int height,
+                          std::vector<unsigned char> &out)
+{
+    unsigned int blockBytes = compressedBlockBytes(format);
+    out.resize(compressedLevelBytes(format, width, height));
+    unsigned char *dst = out.data();
+    unsigned char block[64];
+    for (int by = 0; by < height; by += 4)
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            for (int y = 0; y < 4; y++)
+                for (int x = 0; x < 4; x++)
+                {
+                    int sx = std::min(bx + x, width - 1);
+                    int sy = std::min(by + y, height - 1);
+                    const unsigned char *pixel = rgba + ((size_t) sy * width + sx) * 4;
+                    std::copy(pixel, pixel + 4, block + (y * 4 + x) * 4);
+                }
+            encodeBlock(format, block, dst);
+            dst += blockBytes;
+        }
+}
+#endif
@@ -0,0 +1,164 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/hash.h>
+#include <learnopengl/image.h>
+#include <learnopengl/ktx.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/material.h>
+#include <learnopengl/mipmap.h>
+#include <learnopengl/texture_compression.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// textures are cooked into <image>.ktx next to the source: the whole mip chain, block compressed
+// by usage (BC5 for normal maps, BC4 for height maps, BC1, or BC3 with alpha, for color).
+// a cooked file is used as long as its cook key matches, which covers the cooker version,
+// the usage and the hash of the source file. cooking happens on the loader threads the first
+// time a texture is needed, or up front with --cook.
+const uint32_t TEXTURE_COOK_VERSION = 2;
+
+// which compressed formats the context can sample; S3TC is an extension, RGTC is core since 3.0
+struct TextureCompressionSupport {
+    bool s3tc = false;
+};
+
+inline TextureCompressionSupport &textureCompressionSupport()
+{
+    static TextureCompressionSupport support;
+    return support;
+}
+
+// queries the extensions of the current context; call once on the context thread before loading
+// ------------------------------------------------------------------------
+inline void detectTextureCompression()
+{
+    textureCompressionSupport().s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+}
+
+inline std::string cookedTexturePath(const std::string &source)
+{
+    return source + ".ktx";
+}
+
+inline std::string textureCookKey(uint64_t sourceHash, TextureUsage usage)
+{
+    char key[64];
+    std::snprintf(key, sizeof(key), "v%u usage=%d source=%016llx", TEXTURE_COOK_VERSION, (int) usage,
+                  (unsigned long long) sourceHash);
+    return key;
+}
+
+// color is filtered in linear light with the sharper kernel; normals take the box filter,
+// since the ringing of the wide one bends them at sharp edges
+inline MipOptions mipOptionsForUsage(TextureUsage usage)
+{
+    MipOptions options;
+    options.filter = usage == TEXTURE_USAGE_NORMAL ? MIP_FILTER_BOX : MIP_FILTER_KAISER;
+    options.srgb = usage == TEXTURE_USAGE_COLOR;
+    return options;
+}
+
+inline CompressedFormat cookedFormat(TextureUsage usage, bool hasAlpha)
+{
+    if (usage == TEXTURE_USAGE_NORMAL)
+        return FORMAT_BC5;
+    if (usage == TEXTURE_USAGE_HEIGHT)
+        return FORMAT_BC4;
+    return hasAlpha ? FORMAT_BC3 : FORMAT_BC1;
+}
+
+// decodes an encoded image, builds its mip chain and compresses every level into cooked
+// ------------------------------------------------------------------------
+inline bool cookTexture(const unsigned char *data, size_t size, uint64_t sourceHash, TextureUsage usage,
+                        KtxTexture &cooked)
+{
+    int width, height, components;
+    unsigned char *pixels = stbi_load_from_memory(data, (int) size, &width, &height, &components, 4);
+    if (!pixels)
+        return false;
+
+    bool hasAlpha = false;
+    if (components == 2 || components == 4)
+        for (size_t i = 0; i < (size_t) width * height && !hasAlpha; i++)
+            hasAlpha = pixels[i * 4 + 3] != 255;
+    CompressedFormat format = cookedFormat(usage, hasAlpha);
+
+    std::vector<std::vector<unsigned char>> mips;
+    generateMipChain(pixels, width, height, 4, mipOptionsForUsage(usage), mips);
+
+    std::vector<std::vector<unsigned char>> compressed(mips.size() + 1);
+    compressImage(format, pixels, width, height, compressed[0]);
+    stbi_image_free(pixels);
+    int levelWidth = width, levelHeight = height;
+    for (size_t i = 0; i < mips.size(); i++)
+    {
+        levelWidth = std::max(1, levelWidth / 2);
+        levelHeight = std::max(1, levelHeight / 2);
+        compressImage(format, mips[i].data(), levelWidth, levelHeight, compressed[i + 1]);
+    }
+    cooked.assign(compressedInternalFormat(format), compressedBaseFormat(format), width, height,
+                  std::move(compressed), textureCookKey(sourceHash, usage));
+    return true;
+}
+
+// loads a texture for upload: the cooked file if it is up to date, otherwise the source is cooked
+// (and the result saved) when the context can sample the compressed format, or decoded with its
+// mip chain built on the CPU when it cannot. safe to call from worker threads once
+// detectTextureCompression() has run.
+// ------------------------------------------------------------------------
+inline void loadTextureData(const std::string &path, TextureUsage usage, Image &image)
+{
+    MappedFile file(path);
+    if (!file.valid() || file.size() == 0)
+        return;
+    uint64_t sourceHash = fnv1a64(file.data(), file.size());
+    image.bytesRead = file.size();
+
+    if (usage != TEXTURE_USAGE_COLOR || textureCompressionSupport().s3tc)
+    {
+        std::string cookedPath = cookedTexturePath(path);
+        if (!image.cooked.open(cookedPath) || image.cooked.cookKey != textureCookKey(sourceHash, usage))
+        {
+            if (cookTexture(file.data(), file.size(), sourceHash, usage, image.cooked) &&
+                !image.cooked.write(cookedPath))
+                std::cout << "WARNING::TEXTURE:: could not write cooked texture " << cookedPath << std::endl;
+        }
+        else
+            image.bytesRead += image.cooked.bytes();
+    }
+    if (!image.cooked.valid())
+    {
+        decodeImageFromMemory(file.data(), file.size(), image);
+        if (image.pixels)
+            generateMipChain(image.pixels, image.width, image.height, image.components, mipOptionsForUsage(usage),
+                             image.mips);
+    }
+    // the same file cooked for another usage is a different texture
+    image.contentHash = fnv1a64(&usage, sizeof(usage), sourceHash);
+}
+
+// cooks one texture for the --cook mode; returns false if the source could not be decoded
+// ------------------------------------------------------------------------
+inline bool cookTextureFile(const std::string &path, TextureUsage usage, size_t &sourceBytes, size_t &cookedBytes)
+{
+    MappedFile file(path);
+    if (!file.valid() || file.size() == 0)
+        return false;
+    KtxTexture cooked;
+    if (!cookTexture(file.data(), file.size(), fnv1a64(file.data(), file.size()), usage, cooked))
+        return false;
+    sourceBytes = file.size();
+    cookedBytes = cooked.bytes();
+    return cooked.write(cookedTexturePath(path));
+}
+#endif
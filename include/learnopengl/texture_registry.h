@@ -0,0 +1,167 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/asset_pack.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/image.h>
+#include <learnopengl/material.h>
+#include <learnopengl/texture_cooker.h>
+
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+struct TextureRegistryStats {
+    unsigned int requests = 0;
+    unsigned int hits = 0;          // requests served without decoding or uploading
+    unsigned int contentHits = 0;   // hits on a different path with identical file contents
+    unsigned int uploads = 0;
+    size_t bytesUploaded = 0;
+    size_t bytesSaved = 0;          // texture memory the hits would have uploaded again
+};
+
+// every texture loaded from a file, shared by the whole process. textures are found by canonical
+// path first and by the hash of the file contents second, so the same image referenced by several
+// models, or copied under another name, is decoded and uploaded once. references are counted and
+// the texture is deleted when the last one is released: a Model holds one per loaded texture until
+// it is destroyed, ModelLoader one per standalone texture until releaseTexture or unload. only
+// used from the context thread.
+class TextureRegistry
+{
+public:
+    static TextureRegistry &instance()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    // resolves ., .. and symlinks; paths that don't exist are returned unchanged. files in the
+    // mounted asset pack are named by their key in it, which takes no system calls.
+    // ------------------------------------------------------------------------
+    static std::string canonicalPath(const std::string &path)
+    {
+        if (AssetPack::instance().contains(path))
+            return AssetPack::instance().key(path);
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved))
+            return resolved;
+        return path;
+    }
+
+    // returns the texture for a file and takes a reference, loading it on a miss. the usage
+    // decides how the texture is cooked (see texture_cooker.h).
+    // ------------------------------------------------------------------------
+    unsigned int acquire(const std::string &path, TextureUsage usage = TEXTURE_USAGE_COLOR)
+    {
+        std::string canonical = canonicalPath(path);
+        unsigned int id = 0;
+        if (tryAcquire(canonical, id))
+            return id;
+        Image image;
+        loadTextureData(canonical, usage, image);
+        if (!image.loaded())
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+        return add(canonical, image);
+    }
+
+    // takes a reference to an already registered texture; counts as a request
+    // ------------------------------------------------------------------------
+    bool tryAcquire(const std::string &canonical, unsigned int &id)
+    {
+        stats.requests++;
+        auto found = byPath.find(canonical);
+        if (found == byPath.end())
+            return false;
+        id = found->second;
+        hit(id);
+        return true;
+    }
+
+    // registers an image decoded elsewhere (on a worker, for example) and takes a reference.
+    // if a file with the same contents was registered before, that texture is shared instead.
+    // the request was already counted by tryAcquire.
+    // ------------------------------------------------------------------------
+    unsigned int add(const std::string &canonical, const Image &image)
+    {
+        auto known = byPath.find(canonical);
+        if (known != byPath.end())
+        {
+            hit(known->second);
+            return known->second;
+        }
+        if (image.loaded())
+        {
+            auto same = byContent.find(image.contentHash);
+            if (same != byContent.end())
+            {
+                byPath[canonical] = same->second;
+                stats.contentHits++;
+                hit(same->second);
+                return same->second;
+            }
+        }
+
+        Entry entry;
+        entry.id = uploadTexture(image);
+        entry.bytes = image.loaded() ? image.textureBytes() : 0;
+        entry.contentHash = image.contentHash;
+        entry.references = 1;
+        entries[entry.id] = entry;
+        byPath[canonical] = entry.id;
+        if (image.loaded())
+            byContent[image.contentHash] = entry.id;
+        stats.uploads++;
+        stats.bytesUploaded += entry.bytes;
+        return entry.id;
+    }
+
+    // drops a reference; the last one deletes the texture
+    // ------------------------------------------------------------------------
+    void release(unsigned int id)
+    {
+        auto found = entries.find(id);
+        if (found == entries.end() || --found->second.references > 0)
+            return;
+        for (auto it = byPath.begin(); it != byPath.end();)
+            it = it->second == id ? byPath.erase(it) : std::next(it);
+        auto content = byContent.find(found->second.contentHash);
+        if (content != byContent.end() && content->second == id)
+            byContent.erase(content);
+        GLState::forgetTexture(id);
+        glDeleteTextures(1, &id);
+        entries.erase(found);
+    }
+
+    const TextureRegistryStats &statistics() const { return stats; }
+
+private:
+    struct Entry {
+        unsigned int id = 0;
+        unsigned int references = 0;
+        size_t bytes = 0;
+        uint64_t contentHash = 0;
+    };
+
+    std::unordered_map<unsigned int, Entry> entries;
+    std::unordered_map<std::string, unsigned int> byPath;
+    std::unordered_map<uint64_t, unsigned int> byContent;
+    TextureRegistryStats stats;
+
+    TextureRegistry()
+    {
+    }
+
+    void hit(unsigned int id)
+    {
+        Entry &entry = entries[id];
+        entry.references++;
+        stats.hits++;
+        stats.bytesSaved += entry.bytes;
+    }
+};
+#endif
@@ -0,0 +1,42 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+
+// a uniform buffer object attached to a fixed binding point. programs that declare the
+// matching uniform block are pointed at the same binding point with Shader::bindUniformBlock,
+// so one write per frame reaches all of them.
+class UniformBuffer
+{
+public:
+    unsigned int ID;
+    GLuint bindingPoint;
+    GLsizeiptr size;
+
+    UniformBuffer(GLsizeiptr size, GLuint bindingPoint) : bindingPoint(bindingPoint), size(size)
+    {
+        glGenBuffers(1, &ID);
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ID);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // writes size bytes starting at offset into the buffer
+    // ------------------------------------------------------------------------
+    void update(const void *data, GLsizeiptr dataSize, GLintptr offset = 0)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, dataSize, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // uploads a whole std140 struct in one call
+    // ------------------------------------------------------------------------
+    template<typename T>
+    void update(const T &data)
+    {
+        update(&data, sizeof(T));
+    }
+};
+#endif
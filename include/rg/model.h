@@ -14,6 +14,10 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <rg/Error.h>
+#include <learnopengl/texture_registry.h>
+
+unsigned int TextureFromFile(const char* filename, std::string directory);
+
 class Model {
 public:
     std::vector<Mesh> meshes;
@@ -25,6 +29,16 @@ public:
         loadModel(path);
     }
 
+    // each loaded texture holds a TextureRegistry reference
+    ~Model() {
+        for (const Texture& texture : loaded_textures) {
+            TextureRegistry::instance().release(texture.id);
+        }
+    }
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
     void Draw(Shader& shader) {
         for (Mesh& mesh : meshes) {
             mesh.Draw(shader);
@@ -148,35 +162,7 @@ private:
 
 unsigned int TextureFromFile(const char* filename, std::string directory) {
     std::string fullPath(directory + "/" + filename);
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(fullPath.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_FILTER, GL_LINEAR);
-
-    } else {
-        ASSERT(false, "Failed to load texture image");
-    }
-    stbi_image_free(data);
-    return textureID;
+    return TextureRegistry::instance().acquire(fullPath);
 }
 
 #endif //PROJECT_BASE_MODEL_H
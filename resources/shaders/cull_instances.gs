@@ -0,0 +1,20 @@
+#version 330 core
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in VS_OUT {
+    mat4 instanceMatrix;
+    float visible;
+} gs_in[];
+
+// captured with transform feedback; only visible instances are emitted, so they end up packed
+out mat4 instanceMatrix;
+
+void main() {
+    if (gs_in[0].visible > 0.5) {
+        instanceMatrix = gs_in[0].instanceMatrix;
+        gl_Position = gl_in[0].gl_Position;
+        EmitVertex();
+        EndPrimitive();
+    }
+}
@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 5) in mat4 aInstanceMatrix;
+
+// tests the bounding sphere of one instance against the view frustum; cull_instances.gs keeps
+// the instance if it passed. the same test as the CPU kernels in include/learnopengl/frustum_cull.h
+out VS_OUT {
+    mat4 instanceMatrix;
+    float visible;
+} vs_out;
+
+// inward facing, normalized planes of the view-projection (Frustum::fromMatrix)
+uniform vec4 frustumPlanes[6];
+// object space sphere around everything the instances draw
+uniform vec3 boundsCenter;
+uniform float boundsRadius;
+
+void main() {
+    vec3 center = vec3(aInstanceMatrix * vec4(boundsCenter, 1.0));
+    // the sphere grows with the largest scale of the transform
+    float scale = max(length(aInstanceMatrix[0].xyz), max(length(aInstanceMatrix[1].xyz), length(aInstanceMatrix[2].xyz)));
+    float radius = boundsRadius * scale;
+    bool inside = true;
+    for (int i = 0; i < 6; i++)
+        inside = inside && dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w >= -radius;
+
+    vs_out.instanceMatrix = aInstanceMatrix;
+    vs_out.visible = inside ? 1.0 : 0.0;
+    gl_Position = vec4(center, 1.0);
+}
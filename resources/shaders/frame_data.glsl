@@ -0,0 +1,8 @@
+// matches FrameData in include/learnopengl/frame_data.h (std140)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    vec3 viewPos;
+    float time;
+};
@@ -0,0 +1,36 @@
+// matches LightBlock in include/learnopengl/lights.h (std140)
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    float cutOff;
+    vec3 direction;
+    float outerCutOff;
+    vec3 ambient;
+    float constant;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+};
+
+layout (std140) uniform LightBlock {
+    PointLight pointLight;
+    SpotLight spotlights[3];
+};
+
+// how many of the block's lights are shaded; set per program by its ShaderVariant
+#ifndef POINT_LIGHTS
+#define POINT_LIGHTS 1
+#endif
+#ifndef SPOT_LIGHTS
+#define SPOT_LIGHTS 3
+#endif
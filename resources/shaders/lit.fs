@@ -0,0 +1,124 @@
+#version 330 core
+out vec4 FragColor;
+
+// every lit surface is shaded here; the defines of the program's ShaderVariant
+// (include/learnopengl/shader_variants.h) pick the features at compile time:
+//   NORMAL_MAP                 lighting in tangent space, with the normal from the normal map
+//   PARALLAX_MAPPING           texture coordinates offset along the height map, needs NORMAL_MAP
+//   POINT_LIGHTS, SPOT_LIGHTS  how many lights of the LightBlock are shaded
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+#ifdef NORMAL_MAP
+    vec3 TangentLightPos[4];
+    vec3 TangentLightDirs[3];
+    vec3 TangentViewPos;
+    vec3 TangentFragPos;
+#endif
+} fs_in;
+
+#include "frame_data.glsl"
+#include "lighting.glsl"
+
+struct Material {
+    sampler2D texture_diffuse1;
+    sampler2D texture_specular1;
+    sampler2D normalMap;
+    sampler2D depthMap;
+
+    float shininess;
+};
+
+uniform Material material;
+
+#ifdef PARALLAX_MAPPING
+uniform float heightScale;
+
+vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
+    // number of depth layers
+    const float minLayers = 8;
+    const float maxLayers = 32;
+    float numLayers = mix(maxLayers, minLayers, abs(dot(vec3(0.0, 0.0, 1.0), viewDir)));
+    // calculate the size of each layer
+    float layerDepth = 1.0 / numLayers;
+    // depth of current layer
+    float currentLayerDepth = 0.0;
+    // the amount to shift the texture coordinates per layer (from vector P)
+    vec2 P = viewDir.xy / viewDir.z * heightScale;
+    vec2 deltaTexCoords = P / numLayers;
+
+    // get initial values
+    vec2  currentTexCoords     = texCoords;
+    float currentDepthMapValue = texture(material.depthMap, currentTexCoords).r;
+
+    while(currentLayerDepth < currentDepthMapValue)
+    {
+        // shift texture coordinates along direction of P
+        currentTexCoords -= deltaTexCoords;
+        // get depthmap value at current texture coordinates
+        currentDepthMapValue = texture(material.depthMap, currentTexCoords).r;
+        // get depth of next layer
+        currentLayerDepth += layerDepth;
+    }
+
+    // get texture coordinates before collision (reverse operations)
+    vec2 prevTexCoords = currentTexCoords + deltaTexCoords;
+
+    // get depth after and before collision for linear interpolation
+    float afterDepth  = currentDepthMapValue - currentLayerDepth;
+    float beforeDepth = texture(material.depthMap, prevTexCoords).r - currentLayerDepth + layerDepth;
+
+    // interpolation of texture coordinates
+    float weight = afterDepth / (afterDepth - beforeDepth);
+    vec2 finalTexCoords = prevTexCoords * weight + currentTexCoords * (1.0 - weight);
+
+    return finalTexCoords;
+}
+#endif
+
+void main() {
+#ifdef NORMAL_MAP
+    // normal maps are cooked to two channels (BC5), z is rebuilt from x and y
+    vec2 normalXY = texture(material.normalMap, fs_in.TexCoords).rg * 2.0 - 1.0;
+    vec3 normal = normalize(vec3(normalXY, sqrt(max(0.0, 1.0 - dot(normalXY, normalXY)))));
+    vec3 fragPos = fs_in.TangentFragPos;
+    vec3 viewDir = normalize(fs_in.TangentViewPos - fragPos);
+#else
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 fragPos = fs_in.FragPos;
+    vec3 viewDir = normalize(viewPos - fragPos);
+#endif
+
+    vec2 TexCoords = fs_in.TexCoords;
+#ifdef PARALLAX_MAPPING
+    TexCoords = ParallaxMapping(fs_in.TexCoords, viewDir);
+    if(TexCoords.x > 1.0 || TexCoords.y > 1.0 || TexCoords.x < 0.0 || TexCoords.y < 0.0)
+        discard;
+#endif
+    vec3 albedo = texture(material.texture_diffuse1, TexCoords).rgb;
+    vec3 specularColor = texture(material.texture_specular1, TexCoords).rgb;
+
+    vec3 result = vec3(0.0);
+#if POINT_LIGHTS > 0
+#ifdef NORMAL_MAP
+    vec3 pointLightPos = fs_in.TangentLightPos[0];
+#else
+    vec3 pointLightPos = pointLight.position;
+#endif
+    result += CalcPointLight(pointLight, pointLightPos, normal, fragPos, viewDir, albedo, specularColor,
+                             material.shininess);
+#endif
+    for(int i = 0; i < SPOT_LIGHTS; i++) {
+#ifdef NORMAL_MAP
+        vec3 spotLightPos = fs_in.TangentLightPos[i + 1];
+        vec3 spotDir = fs_in.TangentLightDirs[i];
+#else
+        vec3 spotLightPos = spotlights[i].position;
+        vec3 spotDir = spotlights[i].direction;
+#endif
+        result += CalcSpotLight(spotlights[i], spotLightPos, spotDir, normal, fragPos, viewDir, albedo, specularColor,
+                                material.shininess);
+    }
+    FragColor = vec4(result, 1.0);
+}
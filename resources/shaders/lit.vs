@@ -2,31 +2,34 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#ifdef NORMAL_MAP
 layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aBitangent;
+#endif
 
+// feeds lit.fs for meshes in the standard vertex layout, drawn one at a time
 out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
+#ifdef NORMAL_MAP
     vec3 TangentLightPos[4];
     vec3 TangentLightDirs[3];
     vec3 TangentViewPos;
     vec3 TangentFragPos;
+#endif
 } vs_out;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
+#include "frame_data.glsl"
+#include "lights.glsl"
 
-uniform vec3 lightPos[4];
-uniform vec3 lightDirs[3];
-uniform vec3 viewPos;
+uniform mat4 model;
 
 void main() {
     vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
     vs_out.TexCoords = aTexCoords;
+    vs_out.Normal = aNormal;
 
+#ifdef NORMAL_MAP
     mat3 normalMatrix = transpose(inverse(mat3(model)));
     vec3 T = normalize(normalMatrix * aTangent);
     vec3 N = normalize(normalMatrix * aNormal);
@@ -34,17 +37,16 @@ void main() {
     vec3 B = cross(N, T);
 
     mat3 TBN = transpose(mat3(T, B, N));
-    for(int i = 0; i < 4; i++) {
-        vs_out.TangentLightPos[i] = TBN * lightPos[i];
+#if POINT_LIGHTS > 0
+    vs_out.TangentLightPos[0] = TBN * pointLight.position;
+#endif
+    for(int i = 0; i < SPOT_LIGHTS; i++) {
+        vs_out.TangentLightPos[i + 1] = TBN * spotlights[i].position;
+        vs_out.TangentLightDirs[i] = TBN * spotlights[i].direction;
     }
     vs_out.TangentViewPos = TBN * viewPos;
     vs_out.TangentFragPos = TBN * vs_out.FragPos;
+#endif
 
-    vs_out.Normal = aNormal;
-
-    for(int i = 0; i < 3; i++) {
-        vs_out.TangentLightDirs[i] = TBN * lightDirs[i];
-    }
-
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = viewProj * model * vec4(aPos, 1.0);
 }
@@ -0,0 +1,57 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+#ifdef NORMAL_MAP
+layout (location = 3) in vec4 aTangent;
+#endif
+layout (location = 5) in mat4 aInstanceMatrix;
+
+// feeds lit.fs for instanced meshes in the packed vertex layout
+out VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+#ifdef NORMAL_MAP
+    vec3 TangentLightPos[4];
+    vec3 TangentLightDirs[3];
+    vec3 TangentViewPos;
+    vec3 TangentFragPos;
+#endif
+} vs_out;
+
+// per mesh, maps stored positions to object space (see VertexLayout in include/learnopengl/mesh.h)
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+#include "frame_data.glsl"
+#include "lights.glsl"
+
+void main() {
+    vec3 position = positionOffset + positionScale * aPos;
+    vs_out.FragPos = vec3(aInstanceMatrix * vec4(position, 1.0));
+    vs_out.TexCoords = aTexCoords;
+    vs_out.Normal = aNormal;
+
+#ifdef NORMAL_MAP
+    mat3 normalMatrix = transpose(inverse(mat3(aInstanceMatrix)));
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
+    vec3 N = normalize(normalMatrix * aNormal);
+    T = normalize(T - dot(T, N) * N);
+    // only the sign of w counts: GL 3.3 decodes the 2-bit field as -1/3 or 1/3, not -1 or 1
+    vec3 B = cross(N, T) * (aTangent.w < 0.0 ? -1.0 : 1.0);
+
+    mat3 TBN = transpose(mat3(T, B, N));
+#if POINT_LIGHTS > 0
+    vs_out.TangentLightPos[0] = TBN * pointLight.position;
+#endif
+    for(int i = 0; i < SPOT_LIGHTS; i++) {
+        vs_out.TangentLightPos[i + 1] = TBN * spotlights[i].position;
+        vs_out.TangentLightDirs[i] = TBN * spotlights[i].direction;
+    }
+    vs_out.TangentViewPos = TBN * viewPos;
+    vs_out.TangentFragPos = TBN * vs_out.FragPos;
+#endif
+
+    gl_Position = viewProj * aInstanceMatrix * vec4(position, 1.0);
+}
@@ -9,12 +9,37 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <learnopengl/asset_pack.h>
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/shader_variants.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
-
+#include <learnopengl/model_loader.h>
+#include <learnopengl/lights.h>
+#include <learnopengl/frame_data.h>
+#include <learnopengl/frustum_cull.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/gpu_cull.h>
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/profiler.h>
+#include <learnopengl/program_cache.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/startup_trace.h>
+#include <learnopengl/texture_cooker.h>
+#include <learnopengl/uniform_buffer.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
@@ -22,8 +47,15 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+
 void processInput(GLFWwindow *window);
-unsigned int loadTexture(const char *path);
+int cookTextures();
+int benchMips(const char *path);
+int meshReport();
+int benchObj(const char *path);
+int buildPack();
+int benchCull(size_t maxInstances);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -35,6 +67,13 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
+// profiler overlay, toggled with F1
+bool showProfiler = false;
+
+// framebuffer size, kept up to date by framebuffer_size_callback
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -42,7 +81,99 @@ float lastFrame = 0.0f;
 float heightScale = 0.001;
 const float speed = 1.0f;
 
-int main() {
+// scene assets
+const char *const ALOE_MODEL = "resources/objects/aloe_vera_plant/aloevera.obj";
+const char *const LIGHT_BALL_MODEL = "resources/objects/ball/ball.obj";
+const char *const ROOM_MODEL = "resources/objects/room/untitled.obj";
+const char *const ROOM_HEIGHT_MAP = "resources/objects/room/displacement.png";
+const char *const GLASS_DOOR_MODEL = "resources/objects/room/glass.obj";
+// everything under resources/, packed by --build-pack and mounted at startup when present
+const char *const ASSET_PACK = "resources.pack";
+// linked program binaries, only valid for the driver that wrote them
+const char *const PROGRAM_CACHE_DIRECTORY = "program_cache";
+
+// nothing reads the scene's meshes back on the CPU, so the GPU buffers are their only copy
+ModelLoadOptions sceneLoadOptions()
+{
+    ModelLoadOptions options;
+    options.residency = MESH_RESIDENCY_RELEASE;
+    return options;
+}
+
+// the plant is drawn 90 times a frame, so it takes the compact vertex layout
+ModelLoadOptions aloeLoadOptions()
+{
+    ModelLoadOptions options = sceneLoadOptions();
+    options.layout = VERTEX_LAYOUT_PACKED;
+    return options;
+}
+
+// the ball is flat shaded, but its shader never reads normals, so they don't keep corners apart
+ModelLoadOptions lightBallLoadOptions()
+{
+    ModelLoadOptions options = sceneLoadOptions();
+    options.weldTolerance.normal = 2.0f;
+    return options;
+}
+
+int main(int argc, char **argv) {
+    // everything up to the first presented frame is timed from here
+    StartupTrace &startupTrace = StartupTrace::instance();
+
+    // --cook: compress every texture of the scene ahead of time and exit
+    if (argc > 1 && std::string(argv[1]) == "--cook")
+        return cookTextures();
+    // --bench-mips [image]: time the mip generator kernels and check them against the reference
+    if (argc > 1 && std::string(argv[1]) == "--bench-mips")
+        return benchMips(argc > 2 ? argv[2] : "resources/objects/room/diffuse.jpg");
+    // --mesh-report: import the instanced models again and print what the mesh optimizer does for them
+    if (argc > 1 && std::string(argv[1]) == "--mesh-report")
+        return meshReport();
+    // --bench-obj [obj]: time the native OBJ reader against Assimp on a model and a large generated file,
+    // and check that it produces the same vertices
+    if (argc > 1 && std::string(argv[1]) == "--bench-obj")
+        return benchObj(argc > 2 ? argv[2] : ALOE_MODEL);
+    // --build-pack: cook and cache every asset, then pack resources/ into one file
+    if (argc > 1 && std::string(argv[1]) == "--build-pack")
+        return buildPack();
+    // --bench-cull [instances]: time the frustum culling kernels on 90 up to 1M instances, capped at
+    // instances, and check them
+    if (argc > 1 && std::string(argv[1]) == "--bench-cull")
+        return benchCull(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000);
+
+    // --startup-only: exit after the first presented frame, to time cold and warm starts from scripts
+    // --startup-trace <file>: also write the startup trace as JSON
+    // --no-program-cache: build every program from source and leave the saved binaries alone
+    // --sync-shaders: finish compiling every program before the first frame
+    // --gpu-cull: cull the instanced plants on the GPU with transform feedback instead of on the CPU
+    bool startupOnly = false;
+    bool programCache = true;
+    bool asyncShaders = true;
+    bool gpuCull = false;
+    std::string startupTracePath;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--startup-only")
+            startupOnly = true;
+        else if (argument == "--startup-trace" && i + 1 < argc)
+            startupTracePath = argv[++i];
+        else if (argument == "--no-program-cache")
+            programCache = false;
+        else if (argument == "--sync-shaders")
+            asyncShaders = false;
+        else if (argument == "--gpu-cull")
+            gpuCull = true;
+    }
+    if (programCache)
+        ProgramCache::instance().setDirectory(PROGRAM_CACHE_DIRECTORY);
+    StartupTrace::Clock::time_point phaseStart = StartupTrace::Clock::now();
+    // with a pack mounted, every asset below is read from its mapping instead of loose files
+    if (AssetPack::instance().mount(ASSET_PACK))
+        std::cout << "reading " << AssetPack::instance().fileCount() << " assets from " << ASSET_PACK << std::endl;
+    startupTrace.record("phase", "asset pack", phaseStart);
+    phaseStart = StartupTrace::Clock::now();
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -66,9 +197,11 @@ int main() {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
-    // glfwSetKeyCallback(window, key_callback);
+    glfwSetKeyCallback(window, key_callback);
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    startupTrace.record("phase", "glfw and window", phaseStart);
+    phaseStart = StartupTrace::Clock::now();
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
@@ -76,40 +209,143 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    loadGLExtensions((GLADloadproc) glfwGetProcAddress);
+    detectTextureCompression();
+    startupTrace.record("phase", "glad", phaseStart);
+    phaseStart = StartupTrace::Clock::now();
+
+    // imgui: the glfw backend chains to the callbacks installed above
+    // ----------------------------------------------------------------
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::GetIO().IniFilename = nullptr;
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330 core");
+    startupTrace.record("phase", "imgui", phaseStart);
+    phaseStart = StartupTrace::Clock::now();
 
     // depth testing
-    glEnable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST);
     //glDepthFunc(GL_LESS);
     // blending
-    glEnable(GL_BLEND);
+    GLState::enable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
     stbi_set_flip_vertically_on_load(true);
 
-    Model aloe_vera("resources/objects/aloe_vera_plant/aloevera.obj");
-    Model lightBall("resources/objects/ball/ball.obj");
-    Model room("resources/objects/room/untitled.obj");
-    unsigned int heightMap = loadTexture(string("resources/objects/room/displacement.png").c_str());
-    Model glassDoor("resources/objects/room/glass.obj");
-
-    // instantiation of shaders
-
-    Shader aloeShader("resources/shaders/aloe_vera.vs", "resources/shaders/aloe_vera.fs");
-    Shader lightSource("resources/shaders/light_source.vs", "resources/shaders/light_source.fs");
-    Shader basic("resources/shaders/basic.vs", "resources/shaders/basic.fs");
-    Shader glass("resources/shaders/glass.vs", "resources/shaders/glass.fs");
-    Shader simple("resources/shaders/simple.vs", "resources/shaders/simple.fs");
-    Shader plant("resources/shaders/plant.vs", "resources/shaders/simple.fs");
+    // models are parsed and images decoded on the workers, the uploads happen here as they finish
+    ThreadPool threadPool;
+    ModelLoader loader(threadPool);
+    size_t aloeHandle = loader.addModel(ALOE_MODEL, aloeLoadOptions());
+    size_t lightBallHandle = loader.addModel(LIGHT_BALL_MODEL, lightBallLoadOptions());
+    size_t roomHandle = loader.addModel(ROOM_MODEL, sceneLoadOptions());
+    size_t heightMapHandle = loader.addTexture(ROOM_HEIGHT_MAP, TEXTURE_USAGE_HEIGHT);
+    size_t glassDoorHandle = loader.addModel(GLASS_DOOR_MODEL, sceneLoadOptions());
+    loader.finish();
+
+    Model &aloe_vera = loader.model(aloeHandle);
+    Model &lightBall = loader.model(lightBallHandle);
+    Model &room = loader.model(roomHandle);
+    unsigned int heightMap = loader.texture(heightMapHandle);
+    Model &glassDoor = loader.model(glassDoorHandle);
+    // knowing our model, the walls have normal maps and share the displacement map,
+    // which the obj file doesn't reference, so it is added to their materials here
+    for (int j = 0; j < 4; j++)
+        room.meshes[j].material.setTexture(TEXTURE_HEIGHT, heightMap);
+    startupTrace.record("phase", "models and textures", phaseStart);
+    phaseStart = StartupTrace::Clock::now();
+
+    // instantiation of shaders. every program is submitted here and compiled while the first
+    // frames are drawn; the cheap ones go first, as the fallbacks of the expensive ones
+
+    // lit surfaces are drawn with the variant of lit.fs their material calls for, so only the
+    // combinations the scene uses are compiled
+    ShaderVariants lit("resources/shaders/lit.vs", "resources/shaders/lit.fs");
+    ShaderVariants litInstanced("resources/shaders/lit_instanced.vs", "resources/shaders/lit.fs");
+    Shader lightSource("resources/shaders/light_source.vs", "resources/shaders/light_source.fs", nullptr, "", asyncShaders);
+    Shader glass("resources/shaders/glass.vs", "resources/shaders/glass.fs", nullptr, "", asyncShaders);
+    Shader &roomPlain = lit.get(ShaderVariant::forMaterial(room.meshes[4].material), asyncShaders);
+    Shader &plant = litInstanced.get(ShaderVariant::forMaterial(aloe_vera.meshes[1].material), asyncShaders);
+    Shader &aloeShader = litInstanced.get(ShaderVariant::forMaterial(aloe_vera.meshes[0].material), asyncShaders);
+    Shader &roomParallax = lit.get(ShaderVariant::forMaterial(room.meshes[0].material), asyncShaders);
+
+    // uniforms that never change are set once, when the program is linked
+    aloeShader.whenReady([](Shader &shader) {
+        shader.use();
+        shader.setFloat("material.shininess", 32.0f);
+    });
+    roomParallax.whenReady([](Shader &shader) {
+        shader.use();
+        shader.setFloat("material.shininess", 32.0f);
+        shader.setFloat("heightScale", heightScale);
+    });
+    startupTrace.record("phase", "shaders", phaseStart);
+    phaseStart = StartupTrace::Clock::now();
+
+    // the draw order is decided by the render queue; programs registered first are drawn first,
+    // so the parallax shader comes last and runs against an already filled depth buffer.
+    // until they are compiled, the normal mapped surfaces are drawn without their normal maps
+    RenderQueue renderQueue;
+    unsigned int lightSourceProgram = renderQueue.addProgram(lightSource);
+    unsigned int glassProgram = renderQueue.addProgram(glass);
+    unsigned int plantProgram = renderQueue.addProgram(plant);
+    unsigned int roomPlainProgram = renderQueue.addProgram(roomPlain);
+    unsigned int aloeProgram = renderQueue.addProgram(aloeShader, plantProgram);
+    unsigned int roomParallaxProgram = renderQueue.addProgram(roomParallax, roomPlainProgram);
+
+    // profiler sections; the room is split by program so the parallax shader shows up on its own
+    Profiler profiler;
+    int submitSection = profiler.addSection("submit");
+    int aloeSection = profiler.addSection("aloe instanced");
+    int lightBallSection = profiler.addSection("light balls");
+    int roomParallaxSection = profiler.addSection("room parallax");
+    int roomSimpleSection = profiler.addSection("room simple");
+    int glassSection = profiler.addSection("glass");
+    int overlaySection = profiler.addSection("overlay");
+    renderQueue.setProfiler(&profiler);
 
     // setting point light
     glm::vec3 lightPos(1.0f, 1.0f, 1.0f);
-    glm::vec3 spotlights[] = {
+    glm::vec3 spotlights[NR_SPOT_LIGHTS] = {
             glm::vec3(-6.0f, 1.3f, 2.0f),
             glm::vec3(-4.0f, 0.5f, -3.0f),
             glm::vec3(7.0f, 1.2f, 6.0f)
     };
 
+    // all lit programs read the lights from one uniform buffer; only the positions
+    // and directions change per frame
+    LightBlock lights;
+    lights.pointLight.ambient = glm::vec3(0.2f, 0.2f, 0.2f);
+    lights.pointLight.diffuse = glm::vec3(0.5f, 0.5f, 0.5f);
+    lights.pointLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    lights.pointLight.constant = 1.0f;
+    lights.pointLight.linear = 0.09f;
+    lights.pointLight.quadratic = 0.032f;
+    for (unsigned int i = 0; i < NR_SPOT_LIGHTS; i++) {
+        lights.spotlights[i].position = spotlights[i];
+        lights.spotlights[i].ambient = glm::vec3(0.5f, 0.5f, 0.5f);
+        lights.spotlights[i].diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+        lights.spotlights[i].specular = glm::vec3(1.0f, 1.0f, 1.0f);
+        lights.spotlights[i].constant = 1.0f;
+        lights.spotlights[i].linear = 0.09f;
+        lights.spotlights[i].quadratic = 0.032f;
+        lights.spotlights[i].cutOff = glm::cos(glm::radians(12.5f));
+        lights.spotlights[i].outerCutOff = glm::cos(glm::radians(15.0f));
+    }
+    UniformBuffer lightBuffer(sizeof(LightBlock), LIGHT_BLOCK_BINDING);
+    // camera matrices and position are shared the same way, written once per frame
+    FrameUniforms frameUniforms;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    Shader *programs[] = {&aloeShader, &lightSource, &roomParallax, &glass, &roomPlain, &plant};
+    for (Shader *program : programs) {
+        program->whenReady([](Shader &shader) {
+            shader.bindUniformBlock("LightBlock", LIGHT_BLOCK_BINDING);
+            shader.bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+        });
+    }
+
     // instancing
     unsigned int amount = 90;
     glm::mat4 *modelMatrices;
@@ -123,34 +359,33 @@ int main() {
         }
     }
 
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
-
-    for (int i = 0; i < aloe_vera.meshes.size(); i++) {
-        unsigned int VAO = aloe_vera.meshes[i].VAO;
-        glBindVertexArray(VAO);
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *) 0);
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *) (sizeof(glm::vec4)));
-        glEnableVertexAttribArray(7);
-        glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *) (2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(8);
-        glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *) (3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-        glVertexAttribDivisor(7, 1);
-        glVertexAttribDivisor(8, 1);
-
-        glBindVertexArray(0);
+    // the plants are culled every frame and only the visible ones drawn: on the CPU, streaming the
+    // survivors to the GPU, or with --gpu-cull on the GPU, where the matrices stay. both meshes of
+    // the model draw from the same instances, so one sphere bounds them together
+    glm::vec3 aloeMin, aloeMax;
+    aloe_vera.bounds(aloeMin, aloeMax);
+    InstanceCuller aloeCuller;
+    InstanceBuffer aloeInstances(gpuCull ? 0 : amount);
+    std::unique_ptr<GpuInstanceCuller> aloeGpuCuller;
+    GLintptr aloeDraws[2] = {};
+    if (gpuCull) {
+        aloeGpuCuller.reset(new GpuInstanceCuller(modelMatrices, amount, aloeMin, aloeMax));
+        for (unsigned int i = 0; i < 2; i++) {
+            aloeGpuCuller->attach(aloe_vera.meshes[i].VAO);
+            aloeDraws[i] = aloeGpuCuller->addDraw(aloe_vera.meshes[i]);
+        }
+    } else {
+        aloeCuller.setInstances(modelMatrices, amount, aloeMin, aloeMax);
+        for (const Mesh &mesh : aloe_vera.meshes)
+            aloeInstances.attach(mesh.VAO);
     }
+    delete[] modelMatrices;
 
 
     // draw in wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    startupTrace.record("phase", "scene setup", phaseStart);
+    phaseStart = StartupTrace::Clock::now();
 
     // render loop
     // -----------
@@ -160,6 +395,8 @@ int main() {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        GLState::beginFrame();
+        profiler.beginFrame();
 
         // input
         // -----
@@ -171,256 +408,78 @@ int main() {
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // setting values for aloeVera shader
-        aloeShader.use();
-
-        aloeShader.setVec3("viewPosition", camera.Position);
-
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f,
-                                                100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-
-        aloeShader.setMat4("projection", projection);
-        aloeShader.setMat4("view", view);
-        aloeShader.setVec3("pointLight.position", lightPos);
-        aloeShader.setVec3("pointLight.ambient", 0.2f, 0.2f, 0.2f);
-        aloeShader.setVec3("pointLight.diffuse", 0.5f, 0.5f, 0.5f);
-        aloeShader.setVec3("pointLight.specular", 1.0f, 1.0f, 1.0f);
-        aloeShader.setFloat("pointLight.constant", 1.0f);
-        aloeShader.setFloat("pointLight.linear", 0.09f);
-        aloeShader.setFloat("pointLight.quadratic", 0.032f);
-
-        aloeShader.setVec3("lightPos[" + to_string(0) + "]", lightPos);
-        aloeShader.setVec3("viewPos", camera.Position);
-        aloeShader.setFloat("material.shininess", 32.0f);
-
-        for (int i = 0; i < spotlights->length(); i++) {
-            aloeShader.setVec3("lightPos[" + to_string(i + 1) + "]", spotlights[i]);
-            // our spotlights will follow our movement
-            aloeShader.setVec3("lightDirs[" + to_string(i) + "]", camera.Position - spotlights[i]);
-            aloeShader.setVec3("spotlights[" + to_string(i) + ".ambient", 0.5f, 0.5f, 0.5f);
-            aloeShader.setVec3("spotlights[" + to_string(i) + ".diffuse", 1.0f, 1.0f, 1.0f);
-            aloeShader.setVec3("spotlights[" + to_string(i) + "].specular", 1.0f, 1.0f, 1.0f);
-            aloeShader.setFloat("spotlights[" + to_string(i) + "].constant", 1.0f);
-            aloeShader.setFloat("spotlights[" + to_string(i) + "].linear", 0.09f);
-            aloeShader.setFloat("spotlights[" + to_string(i) + "].quadratic", 0.032f);
-            aloeShader.setVec3("spotlights[" + to_string(i) + "].position", spotlights[i]);
-            aloeShader.setVec3("spotlights[" + to_string(i) + "].direction", camera.Position - spotlights[i]);
-            aloeShader.setFloat("spotlights[" + to_string(i) + "].cutOff", glm::cos(glm::radians(20.5f)));
-            aloeShader.setFloat("spotlights[" + to_string(i) + "].outerCutOff", glm::cos(glm::radians(25.5f)));
-        }
+        // our spotlights will follow our movement
+        lights.pointLight.position = lightPos;
+        for (unsigned int i = 0; i < NR_SPOT_LIGHTS; i++)
+            lights.spotlights[i].direction = camera.Position - spotlights[i];
+        lightBuffer.update(lights);
+
+        // the size framebuffer_size_callback saw last; resize() only marks the projection dirty when it changed
+        frameUniforms.resize(framebufferWidth, framebufferHeight);
+        frameUniforms.update(camera, currentFrame);
+
+        renderQueue.setCamera(camera.Position, frameUniforms.farPlane);
+        profiler.begin(submitSection, false);
 
         // unfortunately, face culling doesn't work well on this model
-        for (int i = 0; i < aloe_vera.meshes[0].textures.size(); i++) {
-            if (aloe_vera.meshes[0].textures[i].type == "texture_diffuse") {
-                aloeShader.setInt("material.texture_diffuse1", i);
-                glActiveTexture(GL_TEXTURE0 + i);
-                glBindTexture(GL_TEXTURE_2D, aloe_vera.meshes[0].textures[i].id);
-            } else if (aloe_vera.meshes[0].textures[i].type == "texture_specular") {
-                aloeShader.setInt("material.texture_specular1", i);
-                glActiveTexture(GL_TEXTURE0 + i);
-                glBindTexture(GL_TEXTURE_2D, aloe_vera.meshes[0].textures[i].id);
-            } else if (aloe_vera.meshes[0].textures[i].type == "texture_normal") {
-                aloeShader.setInt("material.normalMap", i);
-                glActiveTexture(GL_TEXTURE0 + i);
-                glBindTexture(GL_TEXTURE_2D, aloe_vera.meshes[0].textures[i].id);
-            }
+        renderQueue.setSection(aloeSection);
+        unsigned int visiblePlants = 0;
+        if (aloeGpuCuller) {
+            aloeGpuCuller->cull(frameUniforms.data.viewProj);
+            if (aloeGpuCuller->indirect()) {
+                renderQueue.submitIndirect(aloeProgram, aloe_vera.meshes[0], aloeGpuCuller->commands(), aloeDraws[0]);
+                renderQueue.submitIndirect(plantProgram, aloe_vera.meshes[1], aloeGpuCuller->commands(), aloeDraws[1]);
+            } else
+                visiblePlants = aloeGpuCuller->visibleCount();
+        } else {
+            visiblePlants = aloeCuller.cull(frameUniforms.data.viewProj);
+            aloeInstances.update(aloeCuller.visibleMatrices(), visiblePlants);
         }
-        glBindVertexArray(aloe_vera.meshes[0].VAO);
-        glDrawElementsInstanced(GL_TRIANGLES, aloe_vera.meshes[0].indices.size(), GL_UNSIGNED_INT, nullptr, amount);
-        glBindVertexArray(0);
-
-        plant.use();
-        plant.setMat4("projection", projection);
-        plant.setMat4("view", view);
-
-        plant.setVec3("pointLight.position", lightPos);
-        plant.setVec3("pointLight.ambient", 0.2f, 0.2f, 0.2f);
-        plant.setVec3("pointLight.diffuse", 0.5f, 0.5f, 0.5f);
-        plant.setVec3("pointLight.specular", 1.0f, 1.0f, 1.0f);
-        plant.setFloat("pointLight.constant", 1.0f);
-        plant.setFloat("pointLight.linear", 0.09f);
-        plant.setFloat("pointLight.quadratic", 0.032f);
-
-        simple.setVec3("lightPos", lightPos);
-        for (int i = 0; i < spotlights->length(); i++) {
-            plant.setVec3("lightPos[" + to_string(i + 1) + "]", spotlights[i]);
-            plant.setVec3("lightDirs[" + to_string(i) + "]", camera.Position - spotlights[i]);
-            plant.setVec3("spotlights[" + to_string(i) + ".ambient", 0.5f, 0.5f, 0.5f);
-            plant.setVec3("spotlights[" + to_string(i) + ".diffuse", 1.0f, 1.0f, 1.0f);
-            plant.setVec3("spotlights[" + to_string(i) + "].specular", 1.0f, 1.0f, 1.0f);
-            plant.setFloat("spotlights[" + to_string(i) + "].constant", 1.0f);
-            plant.setFloat("spotlights[" + to_string(i) + "].linear", 0.09f);
-            plant.setFloat("spotlights[" + to_string(i) + "].quadratic", 0.032f);
-            plant.setVec3("spotlights[" + to_string(i) + "].position", spotlights[i]);
-            plant.setVec3("spotlights[" + to_string(i) + "].direction", camera.Position - spotlights[i]);
-            plant.setFloat("spotlights[" + to_string(i) + "].cutOff", glm::cos(glm::radians(12.5f)));
-            plant.setFloat("spotlights[" + to_string(i) + "].outerCutOff", glm::cos(glm::radians(15.0f)));
+        if (visiblePlants > 0) {
+            renderQueue.submit(aloeProgram, aloe_vera.meshes[0], glm::mat4(1.0f), PASS_OPAQUE, visiblePlants);
+            renderQueue.submit(plantProgram, aloe_vera.meshes[1], glm::mat4(1.0f), PASS_OPAQUE, visiblePlants);
         }
 
-            for (int i = 0; i < aloe_vera.meshes[1].textures.size(); i++) {
-                if (aloe_vera.meshes[1].textures[i].type == "texture_diffuse") {
-                    aloeShader.setInt("material.texture_diffuse1", i);
-                    glActiveTexture(GL_TEXTURE0 + i);
-                    glBindTexture(GL_TEXTURE_2D, aloe_vera.meshes[1].textures[i].id);
-                } else if (aloe_vera.meshes[1].textures[i].type == "texture_specular") {
-                    aloeShader.setInt("material.texture_specular1", i);
-                    glActiveTexture(GL_TEXTURE0 + i);
-                    glBindTexture(GL_TEXTURE_2D, aloe_vera.meshes[1].textures[i].id);
-                } else if (aloe_vera.meshes[1].textures[i].type == "texture_normal") {
-                    aloeShader.setInt("material.normalMap", i);
-                    glActiveTexture(GL_TEXTURE0 + i);
-                    glBindTexture(GL_TEXTURE_2D, aloe_vera.meshes[1].textures[i].id);
-                }
-            }
-            glBindVertexArray(aloe_vera.meshes[1].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, aloe_vera.meshes[1].indices.size(), GL_UNSIGNED_INT, nullptr, amount);
-            glBindVertexArray(0);
-
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_BACK);
-            glFrontFace(GL_CW);
-            lightSource.use();
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, lightPos);
-            model = glm::scale(model, glm::vec3(1.0f / 20));
-            lightSource.setMat4("view", view);
-            lightSource.setMat4("projection", projection);
-            lightSource.setMat4("model", model);
-            lightBall.Draw(lightSource);
-
-        for (int i = 0; i < spotlights->length(); i++) {
-            lightSource.use();
+        renderQueue.setSection(lightBallSection);
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, lightPos);
+        model = glm::scale(model, glm::vec3(1.0f / 20));
+        renderQueue.submit(lightSourceProgram, lightBall, model, PASS_OPAQUE, 0, true);
+        for (unsigned int i = 0; i < NR_SPOT_LIGHTS; i++) {
             model = glm::mat4(1.0f);
             model = glm::translate(model, spotlights[i]);
             model = glm::scale(model, glm::vec3(1.0f / 20));
-            lightSource.setMat4("model", model);
-            lightBall.Draw(lightSource);
+            renderQueue.submit(lightSourceProgram, lightBall, model, PASS_OPAQUE, 0, true);
         }
 
-            glDisable(GL_CULL_FACE);
-
-            // there's no need to cull faces on our room, as it is made out of 6 planes
-
-            basic.use();
-            basic.setMat4("projection", projection);
-            basic.setMat4("view", view);
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0f, 2.00f, 0.0f));
-            basic.setMat4("model", model);
-
-            basic.setVec3("pointLight.position", lightPos);
-            basic.setVec3("pointLight.ambient", 0.2f, 0.2f, 0.2f);
-            basic.setVec3("pointLight.diffuse", 0.5f, 0.5f, 0.5f);
-            basic.setVec3("pointLight.specular", 1.0f, 1.0f, 1.0f);
-            basic.setFloat("pointLight.constant", 1.0f);
-            basic.setFloat("pointLight.linear", 0.09f);
-            basic.setFloat("pointLight.quadratic", 0.032f);
-
-            basic.setVec3("lightPos", lightPos);
-            for (int i = 0; i < spotlights->length(); i++) {
-                basic.setVec3("lightPos[" + to_string(i + 1) + "]", spotlights[i]);
-                basic.setVec3("lightDirs[" + to_string(i) + "]", camera.Position - spotlights[i]);
-                basic.setVec3("spotlights[" + to_string(i) + ".ambient", 0.5f, 0.5f, 0.5f);
-                basic.setVec3("spotlights[" + to_string(i) + ".diffuse", 1.0f, 1.0f, 1.0f);
-                basic.setVec3("spotlights[" + to_string(i) + "].specular", 1.0f, 1.0f, 1.0f);
-                basic.setFloat("spotlights[" + to_string(i) + "].constant", 1.0f);
-                basic.setFloat("spotlights[" + to_string(i) + "].linear", 0.09f);
-                basic.setFloat("spotlights[" + to_string(i) + "].quadratic", 0.032f);
-                basic.setVec3("spotlights[" + to_string(i) + "].position", spotlights[i]);
-                basic.setVec3("spotlights[" + to_string(i) + "].direction", camera.Position - spotlights[i]);
-                basic.setFloat("spotlights[" + to_string(i) + "].cutOff", glm::cos(glm::radians(12.5f)));
-                basic.setFloat("spotlights[" + to_string(i) + "].outerCutOff", glm::cos(glm::radians(15.0f)));
-            }
-
-            basic.setVec3("viewPos", camera.Position);
-            basic.setFloat("material.shininess", 32.0f);
-            for (int j = 0; j < 4; j++) {
-                for (int i = 0; i < room.meshes[j].textures.size(); i++) {
-                    if (room.meshes[j].textures[i].type == "texture_diffuse") {
-                        basic.setInt("material.texture_diffuse1", i);
-                        glActiveTexture(GL_TEXTURE0 + i);
-                        glBindTexture(GL_TEXTURE_2D, room.meshes[j].textures[i].id);
-                    } else if (room.meshes[j].textures[i].type == "texture_specular") {
-                        basic.setInt("material.texture_specular1", i);
-                        glActiveTexture(GL_TEXTURE0 + i);
-                        glBindTexture(GL_TEXTURE_2D, room.meshes[j].textures[i].id);
-                    } else if (room.meshes[j].textures[i].type == "texture_normal") {
-                        basic.setInt("material.normalMap", i);
-                        glActiveTexture(GL_TEXTURE0 + i);
-                        glBindTexture(GL_TEXTURE_2D, room.meshes[j].textures[i].id);
-                    }
-                }
-                basic.setBool("flag", true);
-                // knowing our model, if there is a normal map, then we know there is a displacement map
-                // loading displacement map
-                // obj file doesn't recognize displacement maps, so we have to load it here
-                basic.setInt("material.depthMap", room.meshes[j].textures.size());
-                glActiveTexture(GL_TEXTURE0 + room.meshes[j].textures.size());
-                glBindTexture(GL_TEXTURE_2D, heightMap);
-                basic.setBool("parallax", true);
-                basic.setFloat("heightScale", heightScale);
-                glBindVertexArray(room.meshes[j].VAO);
-                glDrawElements(GL_TRIANGLES, room.meshes[j].indices.size(), GL_UNSIGNED_INT, nullptr);
-                glBindVertexArray(0);
-            }
-
-            simple.use();
-            simple.setMat4("projection", projection);
-            simple.setMat4("view", view);
-            simple.setMat4("model", model);
-
-            simple.setVec3("pointLight.position", lightPos);
-            simple.setVec3("pointLight.ambient", 0.2f, 0.2f, 0.2f);
-            simple.setVec3("pointLight.diffuse", 0.5f, 0.5f, 0.5f);
-            simple.setVec3("pointLight.specular", 1.0f, 1.0f, 1.0f);
-            simple.setFloat("pointLight.constant", 1.0f);
-            simple.setFloat("pointLight.linear", 0.09f);
-            simple.setFloat("pointLight.quadratic", 0.032f);
-
-            simple.setVec3("lightPos", lightPos);
-            for (int i = 0; i < spotlights->length(); i++) {
-                simple.setVec3("lightPos[" + to_string(i + 1) + "]", spotlights[i]);
-                simple.setVec3("lightDirs[" + to_string(i) + "]", camera.Position - spotlights[i]);
-                simple.setVec3("spotlights[" + to_string(i) + ".ambient", 0.5f, 0.5f, 0.5f);
-                simple.setVec3("spotlights[" + to_string(i) + ".diffuse", 1.0f, 1.0f, 1.0f);
-                simple.setVec3("spotlights[" + to_string(i) + "].specular", 1.0f, 1.0f, 1.0f);
-                simple.setFloat("spotlights[" + to_string(i) + "].constant", 1.0f);
-                simple.setFloat("spotlights[" + to_string(i) + "].linear", 0.09f);
-                simple.setFloat("spotlights[" + to_string(i) + "].quadratic", 0.032f);
-                simple.setVec3("spotlights[" + to_string(i) + "].position", spotlights[i]);
-                simple.setVec3("spotlights[" + to_string(i) + "].direction", camera.Position - spotlights[i]);
-                simple.setFloat("spotlights[" + to_string(i) + "].cutOff", glm::cos(glm::radians(12.5f)));
-                simple.setFloat("spotlights[" + to_string(i) + "].outerCutOff", glm::cos(glm::radians(15.0f)));
-            }
-
-            for (int j = 4; j < 6; j++) {
-
-                for (int i = 0; i < room.meshes[j].textures.size(); i++) {
-                    if (room.meshes[j].textures[i].type == "texture_diffuse") {
-                        basic.setInt("material.texture_diffuse1", i);
-                        glActiveTexture(GL_TEXTURE0 + i);
-                        glBindTexture(GL_TEXTURE_2D, room.meshes[j].textures[i].id);
-                    } else if (room.meshes[j].textures[i].type == "texture_specular") {
-                        basic.setInt("material.texture_specular1", i);
-                        glActiveTexture(GL_TEXTURE0 + i);
-                        glBindTexture(GL_TEXTURE_2D, room.meshes[j].textures[i].id);
-                    } else if (room.meshes[j].textures[i].type == "texture_normal") {
-                        basic.setInt("material.normalMap", i);
-                        glActiveTexture(GL_TEXTURE0 + i);
-                        glBindTexture(GL_TEXTURE_2D, room.meshes[j].textures[i].id);
-                    }
-                }
-                glBindVertexArray(room.meshes[j].VAO);
-                glDrawElements(GL_TRIANGLES, room.meshes[j].indices.size(), GL_UNSIGNED_INT, nullptr);
-                glBindVertexArray(0);
-            }
+        // there's no need to cull faces on our room, as it is made out of 6 planes
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(0.0f, 2.00f, 0.0f));
+        renderQueue.setSection(roomParallaxSection);
+        for (int j = 0; j < 4; j++)
+            renderQueue.submit(roomParallaxProgram, room.meshes[j], model);
+        renderQueue.setSection(roomSimpleSection);
+        for (int j = 4; j < 6; j++)
+            renderQueue.submit(roomPlainProgram, room.meshes[j], model);
+
+        renderQueue.setSection(glassSection);
+        renderQueue.submit(glassProgram, glassDoor, model, PASS_TRANSPARENT);
+        renderQueue.setSection(-1);
+        profiler.end(submitSection);
+        renderQueue.execute();
+
+        if (showProfiler) {
+            ProfileScope scope(profiler, overlaySection, true);
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            profiler.drawOverlay();
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            // imgui sets its own program, textures and blend state
+            GLState::invalidate();
+        }
 
-            glass.use();
-            glass.setMat4("view", view);
-            glass.setMat4("projection", projection);
-            glass.setMat4("model", model);
-            glassDoor.Draw(glass);
             // moving our point light
             model = glm::mat4(1.0f);
             model = glm::rotate(model, speed * deltaTime, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -430,8 +489,31 @@ int main() {
             // -------------------------------------------------------------------------------
             glfwSwapBuffers(window);
             glfwPollEvents();
+
+            // the first frame counts once the GPU is done with it
+            if (!startupTrace.done()) {
+                glFinish();
+                startupTrace.record("phase", "first frame", phaseStart);
+                startupTrace.finish();
+                if (renderQueue.pendingPrograms() > 0)
+                    std::cout << renderQueue.pendingPrograms() << " programs were still compiling at the first frame"
+                              << std::endl;
+                if (startupOnly)
+                    glfwSetWindowShouldClose(window, true);
+            }
         }
 
+        startupTrace.print();
+        if (!startupTracePath.empty() && !startupTrace.writeJson(startupTracePath))
+            std::cout << "Failed to write the startup trace to " << startupTracePath << std::endl;
+
+        // the models and textures go while the context still exists
+        loader.unload();
+
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+
         // glfw: terminate, clearing all previously allocated GLFW resources.
         // ------------------------------------------------------------------
         glfwTerminate();
@@ -460,6 +542,8 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -486,39 +570,407 @@ void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
 
-unsigned int loadTexture(char const * path)
+// glfw: F1 toggles the profiler overlay
+// -------------------------------------
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        showProfiler = !showProfiler;
+}
+
+// cooks the textures of every scene model, and the room's height map, into .ktx files next to
+// them. needs no GL context; the compressed formats are written whether or not this machine
+// can sample them.
+// ---------------------------------------------------------------------------------------------
+int cookTextures()
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    stbi_set_flip_vertically_on_load(true);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
+    std::map<std::string, TextureUsage> textures;
+    textures[TextureRegistry::canonicalPath(ROOM_HEIGHT_MAP)] = TEXTURE_USAGE_HEIGHT;
+    for (const char *path : {ALOE_MODEL, LIGHT_BALL_MODEL, ROOM_MODEL, GLASS_DOOR_MODEL})
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        ModelData data;
+        if (!Model::parse(path, data))
+            continue;
+        for (const MeshData &mesh : data.meshes)
+            for (const TextureRef &texture : mesh.textures)
+                textures[TextureRegistry::canonicalPath(data.directory + '/' + texture.path)] =
+                        textureUsageFromSlot(textureSlotFromType(texture.type));
     }
-    else
+
+    std::mutex mutex;
+    size_t sourceTotal = 0, cookedTotal = 0;
+    int failed = 0;
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        ThreadPool threadPool;
+        for (const auto &texture : textures)
+        {
+            std::string path = texture.first;
+            TextureUsage usage = texture.second;
+            threadPool.submit([&, path, usage]() {
+                size_t sourceBytes = 0, cookedBytes = 0;
+                bool cooked = cookTextureFile(path, usage, sourceBytes, cookedBytes);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!cooked)
+                {
+                    std::cout << "Texture failed to cook: " << path << std::endl;
+                    failed++;
+                    return;
+                }
+                std::cout << "cooked " << path << ": " << sourceBytes / 1024 << " KiB -> " << cookedBytes / 1024
+                          << " KiB" << std::endl;
+                sourceTotal += sourceBytes;
+                cookedTotal += cookedBytes;
+            });
+        }
     }
+    std::cout << textures.size() - failed << " textures cooked, " << sourceTotal / 1024 << " KiB of images -> "
+              << cookedTotal / 1024 << " KiB of mipmapped block compressed textures" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
 
-    return textureID;
+// builds the mip chain of an image as R8, RGB8 and RGBA8 with every filter and kernel set,
+// prints the best of a few runs and fails if a kernel strays from the scalar reference
+// ---------------------------------------------------------------------------------------------
+int benchMips(const char *path)
+{
+    const int runs = 5;
+    bool matches = true;
+    std::cout << "format  filter  srgb  kernels     ms    max error" << std::endl;
+    for (int components : {1, 3, 4})
+    {
+        int width, height, original;
+        unsigned char *pixels = stbi_load(path, &width, &height, &original, components);
+        if (!pixels)
+        {
+            std::cout << "Failed to load " << path << std::endl;
+            return 1;
+        }
+        for (MipFilter filter : {MIP_FILTER_BOX, MIP_FILTER_KAISER})
+            for (bool srgb : {false, true})
+            {
+                if (srgb && components == 1)
+                    continue;
+                MipOptions options;
+                options.filter = filter;
+                options.srgb = srgb;
+
+                std::vector<std::vector<unsigned char>> reference, levels;
+                auto start = std::chrono::steady_clock::now();
+                generateMipChainReference(pixels, width, height, components, options, reference);
+                double referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                const char *format = components == 1 ? "R8" : components == 3 ? "RGB8" : "RGBA8";
+                const char *filterName = filter == MIP_FILTER_BOX ? "box" : "kaiser";
+                printf("%-7s %-7s %-5s %-9s %7.2f\n", format, filterName, srgb ? "yes" : "no", "reference", referenceMs);
+                for (const MipSpanKernels *kernels : mipKernelSets())
+                {
+                    double best = 1e30;
+                    for (int run = 0; run < runs; run++)
+                    {
+                        start = std::chrono::steady_clock::now();
+                        generateMipChain(pixels, width, height, components, options, levels, *kernels);
+                        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                    }
+                    int error = 0;
+                    for (size_t level = 0; level < levels.size(); level++)
+                        for (size_t i = 0; i < levels[level].size(); i++)
+                            error = std::max(error, std::abs(levels[level][i] - reference[level][i]));
+                    matches = matches && error <= 1;
+                    printf("%-7s %-7s %-5s %-9s %7.2f    %d\n", format, filterName, srgb ? "yes" : "no", kernels->name, best, error);
+                }
+            }
+        stbi_image_free(pixels);
+    }
+    std::cout << (matches ? "all kernels within one step of the reference" : "MISMATCH against the reference") << std::endl;
+    return matches ? 0 : 1;
+}
+
+// imports aloevera.obj and ball.obj bypassing the mesh cache and prints the welding savings and
+// the vertex cache statistics of every mesh
+// ---------------------------------------------------------------------------------------------
+int meshReport()
+{
+    const char *paths[] = {ALOE_MODEL, LIGHT_BALL_MODEL};
+    ModelLoadOptions options[] = {aloeLoadOptions(), lightBallLoadOptions()};
+    for (int model = 0; model < 2; model++)
+    {
+        ModelData data(options[model]);
+        data.readCache = false;
+        if (!Model::parse(paths[model], data))
+            return 1;
+        std::string name = std::string(paths[model]).substr(std::string(paths[model]).find_last_of('/') + 1);
+        // what a vertex takes on the GPU in the layout the model is drawn with
+        size_t vertexSize = data.layout == VERTEX_LAYOUT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+        for (size_t i = 0; i < data.reports.size(); i++)
+        {
+            const MeshImportReport &report = data.reports[i];
+            printf("%s mesh %zu: welded %zu -> %zu vertices, %.1f KiB saved at %zu bytes a vertex\n", name.c_str(), i,
+                   report.verticesBefore, report.verticesAfter,
+                   (report.verticesBefore - report.verticesAfter) * vertexSize / 1024.0, vertexSize);
+            printf("%s mesh %zu: %u triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", name.c_str(), i,
+                   report.triangles, report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+        }
+    }
+    return 0;
+}
+
+// writes a wavy grid of size x size quads with positions, texture coordinates and normals,
+// laid out like Blender's exports, as a stand in for a much larger asset than the scene has
+// ---------------------------------------------------------------------------------------------
+bool writeSyntheticObj(const std::string &path, int size)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    fprintf(file, "# synthetic grid for --bench-obj\no Grid\n");
+    for (int z = 0; z <= size; z++)
+        for (int x = 0; x <= size; x++)
+        {
+            float u = (float) x / size, v = (float) z / size;
+            fprintf(file, "v %f %f %f\n", u * 20.0f - 10.0f, 0.5f * std::sin(u * 25.0f) * std::cos(v * 25.0f),
+                    v * 20.0f - 10.0f);
+        }
+    for (int z = 0; z <= size; z++)
+        for (int x = 0; x <= size; x++)
+            fprintf(file, "vt %f %f\n", (float) x / size, (float) z / size);
+    for (int z = 0; z <= size; z++)
+        for (int x = 0; x <= size; x++)
+        {
+            float u = (float) x / size, v = (float) z / size;
+            glm::vec3 normal = glm::normalize(glm::vec3(-0.625f * std::cos(u * 25.0f) * std::cos(v * 25.0f), 1.0f,
+                                                        0.625f * std::sin(u * 25.0f) * std::sin(v * 25.0f)));
+            fprintf(file, "vn %.4f %.4f %.4f\n", normal.x, normal.y, normal.z);
+        }
+    fprintf(file, "s 1\n");
+    for (int z = 0; z < size; z++)
+        for (int x = 0; x < size; x++)
+        {
+            int a = z * (size + 1) + x + 1, b = a + 1, c = a + size + 2, d = a + size + 1;
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+        }
+    return fclose(file) == 0;
+}
+
+// how far apart the corners of the same triangles of two imports are, in the units of each
+// attribute: angles in degrees for the direction vectors
+struct ImportDifference {
+    bool layout = true;     // same meshes, index counts and textures
+    float position = 0.0f;
+    float texCoords = 0.0f;
+    float normal = 0.0f;
+    float tangent = 0.0f;
+    float bitangent = 0.0f;
+};
+
+float vectorAngle(const glm::vec3 &a, const glm::vec3 &b)
+{
+    float lengths = glm::length(a) * glm::length(b);
+    if (lengths == 0.0f)
+        return glm::length(a) == glm::length(b) ? 0.0f : 180.0f;
+    return glm::degrees(std::acos(glm::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f)));
+}
+
+// compares every triangle corner of two imports of the same file. the corners are looked up
+// through each import's indices, so shared and unshared vertices compare alike, and a triangle
+// may start at a different corner as long as its positions line up.
+ImportDifference compareImports(const std::vector<MeshData> &a, const std::vector<MeshData> &b)
+{
+    ImportDifference difference;
+    if (a.size() != b.size())
+    {
+        difference.layout = false;
+        return difference;
+    }
+    for (size_t m = 0; m < a.size(); m++)
+    {
+        const MeshData &meshA = a[m], &meshB = b[m];
+        bool sameTextures = meshA.textures.size() == meshB.textures.size();
+        for (size_t t = 0; sameTextures && t < meshA.textures.size(); t++)
+            sameTextures = meshA.textures[t].type == meshB.textures[t].type && meshA.textures[t].path == meshB.textures[t].path;
+        if (meshA.indexCount != meshB.indexCount || !sameTextures)
+        {
+            difference.layout = false;
+            return difference;
+        }
+        for (unsigned int i = 0; i + 2 < meshA.indexCount; i += 3)
+        {
+            const unsigned int *cornersA = meshA.indexData + i, *cornersB = meshB.indexData + i;
+            int rotation = 0;
+            float closest = 1e30f;
+            for (int r = 0; r < 3; r++)
+            {
+                float distance = 0.0f;
+                for (int c = 0; c < 3; c++)
+                    distance += glm::length(meshA.vertexData[cornersA[c]].Position -
+                                            meshB.vertexData[cornersB[(c + r) % 3]].Position);
+                if (distance < closest)
+                {
+                    closest = distance;
+                    rotation = r;
+                }
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                const Vertex &va = meshA.vertexData[cornersA[c]], &vb = meshB.vertexData[cornersB[(c + rotation) % 3]];
+                difference.position = std::max(difference.position, glm::length(va.Position - vb.Position));
+                difference.texCoords = std::max(difference.texCoords, glm::length(va.TexCoords - vb.TexCoords));
+                difference.normal = std::max(difference.normal, vectorAngle(va.Normal, vb.Normal));
+                difference.tangent = std::max(difference.tangent, vectorAngle(va.Tangent, vb.Tangent));
+                difference.bitangent = std::max(difference.bitangent, vectorAngle(va.Bitangent, vb.Bitangent));
+            }
+        }
+    }
+    return difference;
+}
+
+// imports a model and a generated 512x512 quad grid with Assimp and with the native OBJ reader,
+// prints the best of a few runs and compares the vertices of every triangle corner. it fails
+// unless meshes and textures agree, positions and texture coordinates within 1e-4, normals
+// within 1 degree and tangents and bitangents within 5 degrees (Assimp smooths those across
+// vertices that share a position, the native reader per distinct v/vt/vn).
+// ---------------------------------------------------------------------------------------------
+int benchObj(const char *path)
+{
+    const int runs = 5;
+    const std::string synthetic = "obj_bench_synthetic.obj";
+    if (!writeSyntheticObj(synthetic, 512))
+    {
+        std::cout << "Failed to write " << synthetic << std::endl;
+        return 1;
+    }
+
+    bool matches = true;
+    std::cout << "file                       MiB  importer  meshes  vertices  triangles       ms   MiB/s" << std::endl;
+    for (const std::string &file : {std::string(path), synthetic})
+    {
+        double mib = MappedFile(file).size() / (1024.0 * 1024.0);
+        std::string name = file.substr(file.find_last_of('/') + 1);
+        std::vector<MeshData> imports[2];
+        for (ModelImporter importer : {MODEL_IMPORTER_ASSIMP, MODEL_IMPORTER_OBJ})
+        {
+            std::vector<MeshData> &meshes = imports[importer == MODEL_IMPORTER_OBJ];
+            double best = 1e30;
+            for (int run = 0; run < runs; run++)
+            {
+                meshes.clear();
+                auto start = std::chrono::steady_clock::now();
+                bool imported = importer == MODEL_IMPORTER_OBJ ? loadObj(file, meshes) : Model::importAssimp(file, meshes);
+                best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                if (!imported)
+                {
+                    std::remove(synthetic.c_str());
+                    return 1;
+                }
+            }
+            size_t vertices = 0, count = 0;
+            for (const MeshData &mesh : meshes)
+            {
+                vertices += mesh.vertexCount;
+                count += mesh.indexCount / 3;
+            }
+            printf("%-24s %6.2f  %-8s  %6zu  %8zu  %9zu  %7.2f  %6.1f\n", name.c_str(), mib,
+                   importer == MODEL_IMPORTER_OBJ ? "native" : "assimp", meshes.size(), vertices, count, best,
+                   mib / (best / 1000.0));
+        }
+        ImportDifference difference = compareImports(imports[0], imports[1]);
+        if (difference.layout)
+            printf("%-24s max difference: position %g, uv %g, normal %.3f deg, tangent %.3f deg, bitangent %.3f deg\n",
+                   name.c_str(), difference.position, difference.texCoords, difference.normal, difference.tangent,
+                   difference.bitangent);
+        else
+            printf("%-24s meshes, triangle counts or textures differ\n", name.c_str());
+        matches = matches && difference.layout && difference.position <= 1e-4f && difference.texCoords <= 1e-4f &&
+                  difference.normal <= 1.0f && difference.tangent <= 5.0f && difference.bitangent <= 5.0f;
+    }
+    std::remove(synthetic.c_str());
+    std::cout << (matches ? "both importers produce the same vertices" : "MISMATCH between the importers") << std::endl;
+    return matches ? 0 : 1;
+}
+
+// brings the cooked textures and the mesh caches up to date, so the pack holds what startup
+// reads, and packs everything under resources/ into ASSET_PACK
+// ---------------------------------------------------------------------------------------------
+int buildPack()
+{
+    if (cookTextures() != 0)
+        return 1;
+    const std::pair<const char *, ModelLoadOptions> models[] = {{ALOE_MODEL, aloeLoadOptions()},
+                                                                {LIGHT_BALL_MODEL, lightBallLoadOptions()},
+                                                                {ROOM_MODEL, sceneLoadOptions()},
+                                                                {GLASS_DOOR_MODEL, sceneLoadOptions()}};
+    for (const auto &model : models)
+    {
+        ModelData data(model.second);
+        if (!Model::parse(model.first, data))
+            return 1;
+    }
+
+    size_t files = 0;
+    uint64_t bytes = 0;
+    if (!AssetPack::build("resources", ASSET_PACK, files, bytes))
+    {
+        std::cout << "Failed to write " << ASSET_PACK << std::endl;
+        return 1;
+    }
+    std::cout << "packed " << files << " files, " << bytes / 1024 << " KiB, into " << ASSET_PACK << std::endl;
+    return 0;
+}
+
+// culls 90, 1k, 10k, 100k and 1M random spheres scattered around a camera, capped at
+// maxInstances, with every kernel, prints the best of a few runs and fails if a kernel keeps a
+// different set than the scalar reference
+// ---------------------------------------------------------------------------------------------
+int benchCull(size_t maxInstances)
+{
+    if (maxInstances == 0)
+    {
+        std::cout << "Usage: --bench-cull [instances], with at least 1 instance" << std::endl;
+        return 1;
+    }
+    const int runs = 5;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::fromMatrix(projection * view);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f), size(0.1f, 2.0f);
+    std::vector<float> x(maxInstances), y(maxInstances), z(maxInstances), radius(maxInstances);
+    for (size_t i = 0; i < maxInstances; i++)
+    {
+        x[i] = position(random);
+        y[i] = position(random);
+        z[i] = position(random);
+        radius[i] = size(random);
+    }
+    CullSpheres spheres = {x.data(), y.data(), z.data(), radius.data()};
+
+    bool matches = true;
+    std::vector<uint32_t> reference(maxInstances), visible(maxInstances);
+    std::cout << "instances  kernel   visible         ms  ns/instance" << std::endl;
+    for (size_t count : {(size_t) 90, (size_t) 1000, (size_t) 10000, (size_t) 100000, (size_t) 1000000})
+    {
+        count = std::min(count, maxInstances);
+        size_t referenceCount = cullSpheresScalar(spheres, 0, count, frustum, reference.data());
+        for (const CullKernel &kernel : cullKernels())
+        {
+            double best = 1e30;
+            size_t visibleCount = 0;
+            for (int run = 0; run < runs; run++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                visibleCount = kernel.cull(spheres, 0, count, frustum, visible.data());
+                best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+            bool same = visibleCount == referenceCount &&
+                        std::equal(visible.begin(), visible.begin() + visibleCount, reference.begin());
+            matches = matches && same;
+            printf("%9zu  %-7s %8zu %10.4f  %11.2f%s\n", count, kernel.name, visibleCount, best, best * 1e6 / count,
+                   same ? "" : "  MISMATCH");
+        }
+        if (count == maxInstances)
+            break;
+    }
+    std::cout << (matches ? "all kernels agree with the reference" : "MISMATCH against the reference") << std::endl;
+    return matches ? 0 : 1;
 }